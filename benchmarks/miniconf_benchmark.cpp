@@ -0,0 +1,586 @@
+/*
+ * miniconf benchmark
+ *
+ * A self-contained benchmark of the parsing, loading, lookup and serialization paths.
+ * Each case is repeated until it has run for a minimum time, the time per operation
+ * and the throughput are reported.
+ *
+ * usage: miniconf_benchmark [filter] [--min-time seconds]
+ *     filter: only the cases whose names contain the filter are run
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <functional>
+#include <miniconf.h>
+
+namespace {
+
+    typedef std::chrono::steady_clock Clock;
+
+    // settings of the benchmark run
+    struct Settings {
+        std::string filter;
+        double minTime = 0.5;
+    };
+
+    Settings settings;
+
+    // prevents the compiler from optimizing a result away
+    volatile size_t sink = 0;
+
+    /* Runs a benchmark case
+     *
+     * @name The name of the case
+     * @items The number of items (e.g. tokens or options) processed per operation
+     * @op The operation to be measured, called repeatedly
+     */
+    void run(const std::string& name, size_t items, const std::function<void()>& op)
+    {
+        if (!settings.filter.empty() && name.find(settings.filter) == std::string::npos) {
+            return;
+        }
+        // warm up once, then double the iterations until the minimum time is reached
+        op();
+        size_t iterations = 1;
+        double elapsed = 0.0;
+        while (true) {
+            Clock::time_point start = Clock::now();
+            for (size_t i = 0; i < iterations; ++i) {
+                op();
+            }
+            elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+            if (elapsed >= settings.minTime || iterations >= (size_t(1) << 30)) {
+                break;
+            }
+            iterations *= 2;
+        }
+        double nsPerOp = elapsed * 1e9 / iterations;
+        double itemsPerSec = items * iterations / elapsed;
+        printf("%-32s %12zu iter %16.1f ns/op %14.0f items/s\n",
+                name.c_str(), iterations, nsPerOp, itemsPerSec);
+        fflush(stdout);
+    }
+
+    // the name of a generated option, grouped by sections for nested json
+    std::string flagOf(size_t i)
+    {
+        return "section" + std::to_string(i / 16) + ".option" + std::to_string(i);
+    }
+
+    // defines a number of options of mixed data types, each with a unique short flag
+    void defineOptions(miniconf::Config& conf, size_t count)
+    {
+        conf.description("miniconf benchmark");
+        for (size_t i = 0; i < count; ++i) {
+            miniconf::Config::Option& o = conf.option(flagOf(i));
+            o.shortflag("o" + std::to_string(i)).description("A generated option");
+            switch (i % 4) {
+                case 0: o.defaultValue(static_cast<int>(i)); break;
+                case 1: o.defaultValue(i * 0.5); break;
+                case 2: o.defaultValue(false); break;
+                default: o.defaultValue("value" + std::to_string(i)); break;
+            }
+        }
+    }
+
+    // parses an empty command line, so all the options have their default values
+    void parseDefaults(miniconf::Config& conf)
+    {
+        char name[] = "miniconf_benchmark";
+        char* argv[] = { name };
+        conf.parse(1, argv);
+    }
+
+    // a command line argument value of the i-th option
+    std::string argumentOf(size_t i)
+    {
+        switch (i % 4) {
+            case 0: return std::to_string(i * 3);
+            case 1: return std::to_string(i * 0.25);
+            case 2: return "true";
+            default: return "argument" + std::to_string(i);
+        }
+    }
+
+    // writes a string to a file
+    void writeFile(const std::string& path, const std::string& content)
+    {
+        FILE* fd = fopen(path.c_str(), "wb");
+        if (!fd) {
+            fprintf(stderr, "unable to write %s\n", path.c_str());
+            exit(1);
+        }
+        fwrite(content.data(), 1, content.size(), fd);
+        fclose(fd);
+    }
+
+    // Config::parse() with a synthetic argv of a number of tokens, half long and half short flags
+    void benchParse(size_t tokens)
+    {
+        size_t optionCount = std::max<size_t>(1, std::min<size_t>(tokens / 2, 1000));
+        miniconf::Config conf;
+        defineOptions(conf, optionCount);
+
+        std::vector<std::string> args;
+        args.push_back("miniconf_benchmark");
+        for (size_t i = 0; args.size() - 1 < tokens; ++i) {
+            size_t option = i % optionCount;
+            if (i % 2) {
+                args.push_back("--" + flagOf(option));
+            } else {
+                args.push_back("-o" + std::to_string(option));
+            }
+            args.push_back(argumentOf(option));
+        }
+        std::vector<char*> argv;
+        for (auto && arg : args) {
+            argv.push_back(&arg[0]);
+        }
+
+        run("parse/" + std::to_string(tokens), args.size() - 1, [&]() {
+            sink += conf.parse(static_cast<int>(argv.size()), argv.data());
+        });
+    }
+
+    // Config::parseBatch() with a number of command lines of 10 tokens each
+    void benchParseBatch(size_t count)
+    {
+        const size_t optionCount = 100;
+        miniconf::Config conf;
+        defineOptions(conf, optionCount);
+
+        std::vector<std::vector<std::string> > commandLines(count);
+        for (size_t i = 0; i < count; ++i) {
+            commandLines[i].push_back("miniconf_benchmark");
+            for (size_t j = 0; j < 5; ++j) {
+                size_t option = (i * 5 + j) % optionCount;
+                commandLines[i].push_back("-o" + std::to_string(option));
+                commandLines[i].push_back(argumentOf(option));
+            }
+        }
+        run("parseBatch/" + std::to_string(count), count, [&]() {
+            sink += conf.parseBatch(commandLines);
+        });
+    }
+
+    // Config::config() on generated json / csv files of a number of keys
+    void benchLoad(size_t keys)
+    {
+        miniconf::Config conf;
+        defineOptions(conf, keys);
+        parseDefaults(conf);
+
+        std::string base = "miniconf_benchmark_" + std::to_string(keys);
+#ifdef MINICONF_JSON_SUPPORT
+        std::string jsonPath = base + ".json";
+        writeFile(jsonPath, conf.serialize("", miniconf::Config::ExportFormat::JSON));
+        run("loadJSON/" + std::to_string(keys), keys, [&]() {
+            conf.config(jsonPath);
+        });
+        remove(jsonPath.c_str());
+#endif
+        std::string csvPath = base + ".csv";
+        writeFile(csvPath, conf.serialize("", miniconf::Config::ExportFormat::CSV));
+        run("loadCSV/" + std::to_string(keys), keys, [&]() {
+            conf.config(csvPath);
+        });
+
+        // every loaded value logs an INFO message, counted by a sink
+        size_t messages = 0;
+        conf.log(miniconf::Config::LogLevel::INFO);
+        conf.logSink([&](const miniconf::Config::LogRecord&) { ++messages; });
+        run("loadCSVInfo/" + std::to_string(keys), keys, [&]() {
+            conf.config(csvPath);
+        });
+        sink += messages;
+        conf.log(miniconf::Config::LogLevel::WARNING);
+        remove(csvPath.c_str());
+
+        std::string binaryPath = base + ".bin";
+        writeFile(binaryPath, conf.serialize("", miniconf::Config::ExportFormat::BINARY));
+        run("loadBinary/" + std::to_string(keys), keys, [&]() {
+            conf.config(binaryPath);
+        });
+        remove(binaryPath.c_str());
+    }
+
+    // loading several json (or csv) files of a number of keys, one after another or via configFiles() with a thread per file
+    void benchLoadFiles(size_t keys)
+    {
+        const size_t files = 8;
+        miniconf::Config conf;
+        defineOptions(conf, keys);
+        parseDefaults(conf);
+#ifdef MINICONF_JSON_SUPPORT
+        miniconf::Config::ExportFormat format = miniconf::Config::ExportFormat::JSON;
+        std::string extension = ".json";
+#else
+        miniconf::Config::ExportFormat format = miniconf::Config::ExportFormat::CSV;
+        std::string extension = ".csv";
+#endif
+        std::vector<std::string> paths;
+        for (size_t i = 0; i < files; ++i) {
+            paths.push_back("miniconf_benchmark_files_" + std::to_string(i) + extension);
+            writeFile(paths.back(), conf.serialize("", format));
+        }
+        std::string suffix = std::to_string(files) + "x" + std::to_string(keys);
+        run("loadSequential/" + suffix, keys * files, [&]() {
+            for (auto && path : paths) {
+                conf.config(path);
+            }
+        });
+        run("loadParallel/" + suffix, keys * files, [&]() {
+            sink += conf.configFiles(paths, paths.size());
+        });
+        for (auto && path : paths) {
+            remove(path.c_str());
+        }
+    }
+
+#ifdef MINICONF_SHM_SUPPORT
+    // publishing the values of a number of keys into shared memory, attaching to them as a worker process would, and reading them
+    void benchShared(size_t keys)
+    {
+        miniconf::Config conf;
+        defineOptions(conf, keys);
+        parseDefaults(conf);
+        std::string name = "/miniconf_benchmark_" + std::to_string(keys);
+        run("sharedPublish/" + std::to_string(keys), keys, [&]() {
+            sink += conf.publishShared(name);
+        });
+        run("sharedAttach/" + std::to_string(keys), keys, [&]() {
+            miniconf::Config::SharedSnapshot shared(name);
+            sink += shared.good();
+        });
+
+        std::vector<std::string> flags;
+        for (size_t i = 0; i < keys; ++i) {
+            flags.push_back(flagOf(i));
+        }
+        miniconf::Config::SharedSnapshot shared(name);
+        run("sharedLookup/" + std::to_string(keys), keys, [&]() {
+            for (size_t i = 0; i < keys; ++i) {
+                switch (i % 4) {
+                    case 0: sink += shared.getInt(flags[i]); break;
+                    case 1: sink += static_cast<size_t>(shared.getNumber(flags[i])); break;
+                    case 2: sink += shared.getBoolean(flags[i]); break;
+                    default: sink += shared.getString(flags[i]).size(); break;
+                }
+            }
+            sink += shared.valid();
+        });
+        miniconf::Config::unlinkShared(name);
+    }
+#endif
+
+    // reloading a csv file of long strings and arrays, which are not stored inline, with and without an arena
+    // the arena is only measured when built with MINICONF_ARENA_SUPPORT (miniconf_benchmark_arena)
+    void benchArena(size_t keys)
+    {
+#ifdef MINICONF_ARENA_SUPPORT
+        const std::vector<size_t> blockSizes = {0, size_t(1) << 16};
+#else
+        const std::vector<size_t> blockSizes = {0};
+#endif
+        auto allocate = [](miniconf::Config& conf, size_t blockSize) {
+#ifdef MINICONF_ARENA_SUPPORT
+            conf.arena(blockSize);
+#else
+            (void)conf;
+            (void)blockSize;
+#endif
+        };
+        std::string path = "miniconf_benchmark_arena_" + std::to_string(keys) + ".csv";
+        auto define = [keys](miniconf::Config& conf) {
+            conf.description("miniconf benchmark");
+            for (size_t i = 0; i < keys; ++i) {
+                miniconf::Config::Option& o = conf.option(flagOf(i));
+                o.shortflag("o" + std::to_string(i)).description("A generated option");
+                if (i % 2) {
+                    o.defaultValue(std::vector<double>{0.5 * i, 1.5, 2.5, 3.5, 4.5});
+                } else {
+                    o.defaultValue("a string value which is too long for the inline buffer " + std::to_string(i));
+                }
+            }
+        };
+        {
+            miniconf::Config conf;
+            define(conf);
+            parseDefaults(conf);
+            writeFile(path, conf.serialize("", miniconf::Config::ExportFormat::CSV));
+        }
+        for (size_t blockSize : blockSizes) {
+            std::string mode = blockSize ? "Arena/" : "Heap/";
+            miniconf::Config conf;
+            define(conf);
+            allocate(conf, blockSize);
+            parseDefaults(conf);
+            run("reload" + mode + std::to_string(keys), keys, [&]() {
+                conf.config(path);
+            });
+            run("lifecycle" + mode + std::to_string(keys), keys, [&]() {
+                miniconf::Config temporary;
+                define(temporary);
+                allocate(temporary, blockSize);
+                parseDefaults(temporary);
+                temporary.config(path);
+            });
+        }
+        remove(path.c_str());
+    }
+
+    // stacking config files of a number of keys and reading a few values, eagerly via config() or via layers
+    void benchLayers(size_t keys)
+    {
+        const size_t files = 6;
+        const size_t reads = 200;
+        miniconf::Config schema;
+        defineOptions(schema, keys);
+        parseDefaults(schema);
+        std::string path = "miniconf_benchmark_layers_" + std::to_string(keys) + ".csv";
+        writeFile(path, schema.serialize("", miniconf::Config::ExportFormat::CSV));
+
+        run("stackEager/" + std::to_string(keys), keys * files, [&]() {
+            miniconf::Config conf;
+            defineOptions(conf, keys);
+            parseDefaults(conf);
+            for (size_t i = 0; i < files; ++i) {
+                conf.config(path);
+            }
+            for (size_t i = 0; i < reads; ++i) {
+                sink += static_cast<size_t>(conf[flagOf(i * keys / reads)].type());
+            }
+        });
+        run("stackLayers/" + std::to_string(keys), keys * files, [&]() {
+            miniconf::Config conf;
+            defineOptions(conf, keys);
+            for (size_t i = 0; i < files; ++i) {
+                conf.loadLayer(conf.addLayer("file" + std::to_string(i)), path);
+            }
+            parseDefaults(conf);
+            for (size_t i = 0; i < reads; ++i) {
+                sink += static_cast<size_t>(conf[flagOf(i * keys / reads)].type());
+            }
+        });
+
+        // a runtime override of one value, published to the readers of the snapshots
+        miniconf::Config eager;
+        defineOptions(eager, keys);
+        parseDefaults(eager);
+        for (size_t i = 0; i < files; ++i) {
+            eager.config(path);
+        }
+        run("overrideEager/" + std::to_string(keys), 1, [&]() {
+            eager[flagOf(0)] = static_cast<int>(sink & 1);
+            eager.publish();
+            sink += static_cast<size_t>((*eager.snapshot())[flagOf(0)].getInt());
+        });
+        miniconf::Config layered;
+        defineOptions(layered, keys);
+        for (size_t i = 0; i < files; ++i) {
+            layered.loadLayer(layered.addLayer("file" + std::to_string(i)), path);
+        }
+        size_t overrides = layered.addLayer("overrides");
+        parseDefaults(layered);
+        run("overrideLayers/" + std::to_string(keys), 1, [&]() {
+            layered.setLayerValue(overrides, flagOf(0), miniconf::Value(static_cast<int>(sink & 1)));
+            layered.publish();
+            sink += static_cast<size_t>((*layered.snapshot())[flagOf(0)].getInt());
+        });
+        remove(path.c_str());
+    }
+
+    // Config::operator[] and typed handle lookups in a config of a number of options
+    void benchLookup(size_t count)
+    {
+        miniconf::Config conf;
+        defineOptions(conf, count);
+        parseDefaults(conf);
+
+        std::vector<std::string> flags;
+        for (size_t i = 0; i < count; ++i) {
+            flags.push_back(flagOf(i));
+        }
+        run("lookup/" + std::to_string(count), count, [&]() {
+            for (auto && flag : flags) {
+                sink += static_cast<size_t>(conf[flag].type());
+            }
+        });
+
+        std::vector<miniconf::Config::Handle<int> > handles;
+        for (size_t i = 0; i < count; i += 4) {
+            handles.push_back(conf.handle<int>(flagOf(i)));
+        }
+        run("handle/" + std::to_string(count), handles.size(), [&]() {
+            for (auto && h : handles) {
+                sink += conf.get(h);
+            }
+        });
+    }
+
+    // reading an enumerated setting a number of times, by name from a STRING option and by index from a CHOICE option
+    void benchChoice(size_t count)
+    {
+        miniconf::Config conf;
+        conf.option("modeString").defaultValue("slow");
+        conf.option("modeChoice").choices({"fast", "balanced", "slow", "off"}).defaultValue("slow");
+        parseDefaults(conf);
+
+        miniconf::Config::Handle<miniconf::StringRef> stringHandle = conf.handle<miniconf::StringRef>("modeString");
+        run("choiceByName/" + std::to_string(count), count, [&]() {
+            for (size_t i = 0; i < count; ++i) {
+                miniconf::StringRef mode = conf.get(stringHandle);
+                if (mode == "fast") {
+                    sink += 1;
+                } else if (mode == "balanced") {
+                    sink += 2;
+                } else if (mode == "slow") {
+                    sink += 3;
+                }
+            }
+        });
+        miniconf::Config::Handle<int> choiceHandle = conf.handle<int>("modeChoice");
+        run("choiceByIndex/" + std::to_string(count), count, [&]() {
+            for (size_t i = 0; i < count; ++i) {
+                switch (conf.get(choiceHandle)) {
+                    case 0: sink += 1; break;
+                    case 1: sink += 2; break;
+                    case 2: sink += 3; break;
+                    default: break;
+                }
+            }
+        });
+    }
+
+    // Config::checkFormat() of a number of options, the schema is modified to skip the cached result
+    void benchCheckFormat(size_t count)
+    {
+        miniconf::Config conf;
+        defineOptions(conf, count);
+        run("checkFormat/" + std::to_string(count), count, [&]() {
+            conf.description("miniconf benchmark");
+            sink += static_cast<size_t>(conf.checkFormat());
+        });
+    }
+
+    // rendering the help message of a number of options, and reading the cached message
+    void benchHelp(size_t count)
+    {
+        miniconf::Config conf;
+        defineOptions(conf, count);
+        run("helpRender/" + std::to_string(count), count, [&]() {
+            conf.description("miniconf benchmark");
+            sink += conf.helpText().size();
+        });
+        run("helpCached/" + std::to_string(count), 1, [&]() {
+            sink += conf.helpText().size();
+        });
+    }
+
+    // completing a section prefix to the flags of a number of options, with the trie and by a scan of all flags
+    void benchComplete(size_t count)
+    {
+        miniconf::Config conf;
+        defineOptions(conf, count);
+        std::vector<std::string> prefixes;
+        for (size_t i = 0; i < count; i += 16) {
+            prefixes.push_back("--section" + std::to_string(i / 16) + ".");
+        }
+        std::vector<std::string> flags;
+        const miniconf::FlagTrie& trie = conf.flagTrie();
+        for (size_t i = 0; i < trie.size(); ++i) {
+            flags.push_back(trie.word(i).str());
+        }
+        size_t next = 0;
+        run("completeScan/" + std::to_string(count), 1, [&]() {
+            const std::string& prefix = prefixes[next++ % prefixes.size()];
+            for (auto && flag : flags) {
+                if (flag.compare(0, prefix.size(), prefix) == 0) {
+                    ++sink;
+                }
+            }
+        });
+        run("completeTrie/" + std::to_string(count), 1, [&]() {
+            sink += conf.complete(prefixes[next++ % prefixes.size()]).size();
+        });
+    }
+
+    // Config::serialize() of a number of values into a buffer
+    void benchSerialize(size_t count)
+    {
+        miniconf::Config conf;
+        defineOptions(conf, count);
+        parseDefaults(conf);
+
+        std::vector<char> buffer(conf.serialize(nullptr, 0, miniconf::Config::ExportFormat::CSV) * 4 + 1024);
+#ifdef MINICONF_JSON_SUPPORT
+        run("serializeJSON/" + std::to_string(count), count, [&]() {
+            sink += conf.serialize(buffer.data(), buffer.size(), miniconf::Config::ExportFormat::JSON);
+        });
+#endif
+        run("serializeCSV/" + std::to_string(count), count, [&]() {
+            sink += conf.serialize(buffer.data(), buffer.size(), miniconf::Config::ExportFormat::CSV);
+        });
+        run("serializeBinary/" + std::to_string(count), count, [&]() {
+            sink += conf.serialize(buffer.data(), buffer.size(), miniconf::Config::ExportFormat::BINARY);
+        });
+    }
+}
+
+/* Main file */
+int main(int argc, char** argv)
+{
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--min-time") == 0 && i + 1 < argc) {
+            settings.minTime = atof(argv[++i]);
+        } else {
+            settings.filter = argv[i];
+        }
+    }
+
+    for (size_t tokens : {10, 1000, 100000}) {
+        benchParse(tokens);
+    }
+    for (size_t count : {1000, 10000}) {
+        benchParseBatch(count);
+    }
+    for (size_t keys : {100, 10000, 100000}) {
+        benchLoad(keys);
+    }
+    for (size_t keys : {1000, 100000}) {
+        benchLoadFiles(keys);
+    }
+#ifdef MINICONF_SHM_SUPPORT
+    for (size_t keys : {100, 10000, 100000}) {
+        benchShared(keys);
+    }
+#endif
+    for (size_t keys : {1000, 100000}) {
+        benchArena(keys);
+    }
+    for (size_t keys : {1000, 10000}) {
+        benchLayers(keys);
+    }
+    for (size_t count : {100, 10000}) {
+        benchLookup(count);
+    }
+    benchChoice(10000);
+    for (size_t count : {100, 1000, 10000}) {
+        benchCheckFormat(count);
+    }
+    for (size_t count : {100, 1000}) {
+        benchHelp(count);
+    }
+    for (size_t count : {1000, 100000}) {
+        benchComplete(count);
+    }
+    for (size_t count : {100, 10000}) {
+        benchSerialize(count);
+    }
+    return static_cast<int>(sink & 0);
+}
@@ -0,0 +1,322 @@
+/*
+ * miniconf scaling stress test
+ *
+ * Generates configs of increasing key count, nesting depth and value size, loads
+ * them, and checks that the loading time and memory grow linearly: from one size 
+ * to the next, 4 times larger one, the cost per unit (key, level, byte or element) 
+ * may grow at most by a tolerance factor. A quadratic cost grows by 4 at each step, 
+ * while the cache misses of large inputs only add a bounded step. The time is the 
+ * minimum of several runs, the memory is the peak of the bytes allocated while 
+ * loading. The timing depends on the machine, so it is a stress tool rather than 
+ * a unit test.
+ *
+ * usage: miniconf_scaling [filter] [--tolerance factor]
+ *     filter: only the series whose names contain the filter are run
+ *     exit status: 1 if a series grows faster than linearly
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <chrono>
+#include <new>
+#include <string>
+#include <vector>
+#include <functional>
+#include <algorithm>
+#include <memory>
+#include <miniconf.h>
+
+namespace {
+
+    typedef std::chrono::steady_clock Clock;
+
+    // bytes allocated by operator new and not released yet, and their peak
+    size_t liveBytes = 0;
+    size_t peakBytes = 0;
+
+    // each allocation is prefixed by its size, aligned for any type
+    const size_t ALLOCATION_HEADER = 16;
+
+    void* allocate(size_t size)
+    {
+        char* p = static_cast<char*>(malloc(size + ALLOCATION_HEADER));
+        if (!p) {
+            return nullptr;
+        }
+        memcpy(p, &size, sizeof(size_t));
+        liveBytes += size;
+        peakBytes = std::max(peakBytes, liveBytes);
+        return p + ALLOCATION_HEADER;
+    }
+
+    void release(void* ptr)
+    {
+        if (!ptr) {
+            return;
+        }
+        char* p = static_cast<char*>(ptr) - ALLOCATION_HEADER;
+        size_t size;
+        memcpy(&size, p, sizeof(size_t));
+        liveBytes -= size;
+        free(p);
+    }
+}
+
+void* operator new(size_t size)
+{
+    void* p = allocate(size);
+    if (!p) throw std::bad_alloc();
+    return p;
+}
+
+void* operator new[](size_t size)
+{
+    void* p = allocate(size);
+    if (!p) throw std::bad_alloc();
+    return p;
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept
+{
+    return allocate(size);
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) noexcept
+{
+    return allocate(size);
+}
+
+void operator delete(void* ptr) noexcept
+{
+    release(ptr);
+}
+
+void operator delete[](void* ptr) noexcept
+{
+    release(ptr);
+}
+
+void operator delete(void* ptr, const std::nothrow_t&) noexcept
+{
+    release(ptr);
+}
+
+void operator delete[](void* ptr, const std::nothrow_t&) noexcept
+{
+    release(ptr);
+}
+
+namespace {
+
+    // settings of the run
+    struct Settings {
+        std::string filter;
+        double tolerance = 2.5;
+        int runs = 5;
+    };
+
+    Settings settings;
+
+    // cost of loading an input of a size
+    struct Measurement {
+        size_t size;
+        double seconds;
+        size_t bytes;
+    };
+
+    /* Prepares the Config and the input of a size, and returns the operation to be measured
+     *
+     * The Config is copied for each run, so every run loads into the same state.
+     */
+    typedef std::function<std::function<void(miniconf::Config&)>(size_t size, miniconf::Config& conf)> Setup;
+
+    // the name of the i-th generated option
+    std::string flagOf(size_t i)
+    {
+        return "section" + std::to_string(i / 16) + ".option" + std::to_string(i);
+    }
+
+    // defines a number of integer options
+    void defineOptions(miniconf::Config& conf, size_t count)
+    {
+        conf.log(miniconf::Config::LogLevel::NONE);
+        conf.enableHelp(false);
+        conf.enableConfig(false);
+        for (size_t i = 0; i < count; ++i) {
+            conf.option(flagOf(i)).defaultValue(0);
+        }
+    }
+
+    /* Measures a series of sizes and checks that the costs per unit do not grow
+     *
+     * @return False if the time or the memory per unit grows more than the tolerance between two sizes
+     */
+    bool series(const std::string& name, const char* unit, const std::vector<size_t>& sizes, const Setup& setup)
+    {
+        if (!settings.filter.empty() && name.find(settings.filter) == std::string::npos) {
+            return true;
+        }
+        std::vector<Measurement> measurements;
+        for (auto && size : sizes) {
+            miniconf::Config prototype;
+            std::function<void(miniconf::Config&)> op = setup(size, prototype);
+            Measurement m = { size, 1e300, 0 };
+            for (int run = 0; run < settings.runs; ++run) {
+                miniconf::Config conf(prototype);
+                size_t before = liveBytes;
+                peakBytes = liveBytes;
+                Clock::time_point start = Clock::now();
+                op(conf);
+                double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+                m.seconds = std::min(m.seconds, seconds);
+                m.bytes = std::max(m.bytes, peakBytes - before);
+            }
+            measurements.push_back(m);
+            printf("%-24s %10zu %-8s %12.3f ms %10.1f ns/%-8s %12zu bytes %8.1f bytes/%s\n",
+                    (name + "/" + std::to_string(size)).c_str(), size, unit, m.seconds * 1e3,
+                    m.seconds * 1e9 / size, unit, m.bytes, static_cast<double>(m.bytes) / size, unit);
+            fflush(stdout);
+        }
+        // the largest growth of the costs per unit between two sizes, a few bytes are not compared
+        double timeGrowth = 1.0;
+        double memoryGrowth = 1.0;
+        for (size_t i = 1; i < measurements.size(); ++i) {
+            const Measurement& previous = measurements[i - 1];
+            const Measurement& current = measurements[i];
+            timeGrowth = std::max(timeGrowth, (current.seconds / current.size) / (previous.seconds / previous.size));
+            if (previous.bytes >= 1024) {
+                memoryGrowth = std::max(memoryGrowth, (static_cast<double>(current.bytes) / current.size) / (static_cast<double>(previous.bytes) / previous.size));
+            }
+        }
+        bool linear = timeGrowth <= settings.tolerance && memoryGrowth <= settings.tolerance;
+        printf("%-24s %s, cost per %s grows up to x%.2f time, x%.2f memory\n\n", name.c_str(),
+                linear ? "linear" : "SUPERLINEAR", unit, timeGrowth, memoryGrowth);
+        return linear;
+    }
+
+    // loads a text content into a copy of the Config
+    std::function<void(miniconf::Config&)> loader(const std::string& content, miniconf::Config::ExportFormat format)
+    {
+        return [content, format](miniconf::Config& conf) {
+            conf.deserialize(content, format);
+        };
+    }
+}
+
+/* Main file */
+int main(int argc, char** argv)
+{
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--tolerance") == 0 && i + 1 < argc) {
+            settings.tolerance = atof(argv[++i]);
+        } else {
+            settings.filter = argv[i];
+        }
+    }
+
+    const std::vector<size_t> keys = {1000, 4000, 16000, 64000};
+    bool linear = true;
+
+#ifdef MINICONF_JSON_SUPPORT
+    // nested json objects of defined options
+    linear = series("jsonKeys", "key", keys, [](size_t size, miniconf::Config& conf) {
+        defineOptions(conf, size);
+        std::string json = "{";
+        for (size_t i = 0; i < size; i += 16) {
+            json += (i > 0 ? ", \"section" : "\"section") + std::to_string(i / 16) + "\": {";
+            for (size_t j = i; j < std::min(i + 16, size); ++j) {
+                json += (j > i ? ", \"option" : "\"option") + std::to_string(j) + "\": " + std::to_string(j);
+            }
+            json += "}";
+        }
+        json += "}";
+        return loader(json, miniconf::Config::ExportFormat::JSON);
+    }) && linear;
+
+    // a chain of nested objects with a value at the innermost level, the depth limit is disabled
+    linear = series("jsonDepth", "level", {256, 512, 1024, 2048}, [](size_t size, miniconf::Config& conf) {
+        defineOptions(conf, 0);
+        conf.jsonLimits(0, 0);
+        std::string json;
+        for (size_t i = 0; i < size; ++i) {
+            json += "{\"n\": ";
+        }
+        json += "1";
+        json.append(size, '}');
+        return loader(json, miniconf::Config::ExportFormat::JSON);
+    }) && linear;
+
+    // a long json string
+    linear = series("jsonValueSize", "byte", {1 << 16, 1 << 18, 1 << 20, 1 << 22}, [](size_t size, miniconf::Config& conf) {
+        defineOptions(conf, 0);
+        conf.option("value").defaultValue("");
+        std::string json = "{\"value\": \"" + std::string(size, 'x') + "\"}";
+        return loader(json, miniconf::Config::ExportFormat::JSON);
+    }) && linear;
+#endif
+
+    // csv records of defined options
+    linear = series("csvKeys", "key", keys, [](size_t size, miniconf::Config& conf) {
+        defineOptions(conf, size);
+        std::string csv;
+        for (size_t i = 0; i < size; ++i) {
+            csv += flagOf(i) + "," + std::to_string(i) + "\n";
+        }
+        return loader(csv, miniconf::Config::ExportFormat::CSV);
+    }) && linear;
+
+    // a long quoted csv field with escaped quotes
+    linear = series("csvValueSize", "byte", {1 << 16, 1 << 18, 1 << 20, 1 << 22}, [](size_t size, miniconf::Config& conf) {
+        defineOptions(conf, 0);
+        conf.option("value").defaultValue("");
+        std::string field;
+        for (size_t i = 0; i < size; i += 8) {
+            field += "xxxxxx\"\"";
+        }
+        return loader("value,\"" + field + "\"\n", miniconf::Config::ExportFormat::CSV);
+    }) && linear;
+
+    // a long csv line of array elements
+    linear = series("csvLineLength", "element", keys, [](size_t size, miniconf::Config& conf) {
+        defineOptions(conf, 0);
+        conf.option("values").defaultValue(std::vector<std::string>());
+        std::string csv = "values";
+        for (size_t i = 0; i < size; ++i) {
+            csv += ",element" + std::to_string(i);
+        }
+        return loader(csv + "\n", miniconf::Config::ExportFormat::CSV);
+    }) && linear;
+
+    // command line arguments of defined options
+    linear = series("argvKeys", "key", keys, [](size_t size, miniconf::Config& conf) {
+        defineOptions(conf, size);
+        std::shared_ptr<std::vector<std::string> > arguments = std::make_shared<std::vector<std::string> >();
+        arguments->push_back("miniconf_scaling");
+        for (size_t i = 0; i < size; ++i) {
+            arguments->push_back("--" + flagOf(i));
+            arguments->push_back(std::to_string(i));
+        }
+        return [arguments](miniconf::Config& conf) {
+            std::vector<char*> argv;
+            for (auto && argument : *arguments) {
+                argv.push_back(const_cast<char*>(argument.c_str()));
+            }
+            conf.parse(static_cast<int>(argv.size()), argv.data());
+        };
+    }) && linear;
+
+    // a binary config of defined options
+    linear = series("binaryKeys", "key", keys, [](size_t size, miniconf::Config& conf) {
+        defineOptions(conf, size);
+        miniconf::Config source(conf);
+        for (size_t i = 0; i < size; ++i) {
+            source[flagOf(i)] = static_cast<int>(i);
+        }
+        std::string binary(source.serialize(nullptr, 0, miniconf::Config::ExportFormat::BINARY) + 1, '\0');
+        binary.resize(source.serialize(&binary[0], binary.size(), miniconf::Config::ExportFormat::BINARY));
+        return loader(binary, miniconf::Config::ExportFormat::BINARY);
+    }) && linear;
+
+    return linear ? 0 : 1;
+}
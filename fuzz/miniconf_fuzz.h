@@ -0,0 +1,54 @@
+/*
+ * miniconf fuzz targets
+ *
+ * Each target feeds its input to one ingestion path of miniconf, the schema below
+ * covers all the data types, nested flags and a choice, so the typed conversions 
+ * are reached. The targets are built with libFuzzer, or with the standalone driver 
+ * for AFL and for reproducing a crash (see miniconf_fuzz_main.cpp).
+ */
+
+#ifndef __MINICONF_FUZZ_H__
+#define __MINICONF_FUZZ_H__
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+#include <miniconf.h>
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size);
+
+namespace miniconf_fuzz {
+
+    // defines options of each data type, the log is not printed
+    static void defineOptions(miniconf::Config& conf)
+    {
+        conf.log(miniconf::Config::LogLevel::NONE);
+        conf.enableHelp(false);
+        conf.enableConfig(false);
+        conf.description("miniconf fuzz target");
+        conf.option("int").shortflag("i").defaultValue(1).description("an integer");
+        conf.option("number").shortflag("n").defaultValue(0.5).description("a number");
+        conf.option("bool").shortflag("b").defaultValue(false).description("a boolean");
+        conf.option("string").shortflag("s").defaultValue("text").description("a string");
+        conf.option("part.ints").defaultValue(std::vector<int>{1, 2}).description("integers");
+        conf.option("part.numbers").defaultValue(std::vector<double>{0.5}).description("numbers");
+        conf.option("part.bools").defaultValue(std::vector<bool>{true}).description("booleans");
+        conf.option("part.strings").defaultValue(std::vector<std::string>{"a"}).description("strings");
+        conf.option("part.sub.mode").shortflag("m").choices({"fast", "slow"}).defaultValue("fast").description("a choice");
+        conf.option("part.sub.required").shortflag("r").defaultValue(0).required(true).description("a required value");
+    }
+
+    // reads all the values, so the loaded buffers are accessed
+    static size_t touchValues(miniconf::Config& conf)
+    {
+        size_t sum = 0;
+        for (auto && flag : {"int", "number", "bool", "string", "part.ints", "part.numbers", "part.bools", "part.strings", "part.sub.mode"}) {
+            sum += conf[flag].print().size();
+        }
+        conf.validate();
+        return sum;
+    }
+}
+
+#endif // __MINICONF_FUZZ_H__
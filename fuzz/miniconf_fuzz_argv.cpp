@@ -0,0 +1,31 @@
+/*
+ * Fuzz target of the command line parser
+ *
+ * The input is split into arguments at null characters and newlines.
+ */
+
+#include "miniconf_fuzz.h"
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size)
+{
+    // the arguments are null-terminated strings in one buffer
+    std::vector<char> buffer(data, data + size);
+    buffer.push_back('\0');
+    std::vector<char*> argv;
+    static char name[] = "miniconf_fuzz_argv";
+    argv.push_back(name);
+    char* first = buffer.data();
+    for (size_t i = 0; i < buffer.size(); ++i) {
+        if (buffer[i] == '\n' || buffer[i] == '\0') {
+            buffer[i] = '\0';
+            argv.push_back(first);
+            first = buffer.data() + i + 1;
+        }
+    }
+
+    miniconf::Config conf;
+    miniconf_fuzz::defineOptions(conf);
+    conf.parse(static_cast<int>(argv.size()), argv.data());
+    miniconf_fuzz::touchValues(conf);
+    return 0;
+}
@@ -0,0 +1,55 @@
+/*
+ * Fuzz target of the binary loader
+ *
+ * The input is loaded as it is, and XORed onto a valid binary config, so the 
+ * mutations also reach the value records behind the header checks.
+ */
+
+#include <cstring>
+#include "miniconf_fuzz.h"
+
+namespace {
+
+    // loads a binary config from an 8-byte aligned copy, like a mapped file
+    void load(const char* data, size_t size)
+    {
+        std::vector<uint64_t> aligned((size + 7) / 8);
+        if (size > 0) {
+            memcpy(aligned.data(), data, size);
+        }
+        miniconf::Config conf;
+        miniconf_fuzz::defineOptions(conf);
+        conf.deserialize(miniconf::StringRef(reinterpret_cast<const char*>(aligned.data()), size), miniconf::Config::ExportFormat::BINARY);
+        miniconf_fuzz::touchValues(conf);
+    }
+
+    // a binary config of all the options
+    const std::string& seed()
+    {
+        static std::string content;
+        if (content.empty()) {
+            miniconf::Config conf;
+            miniconf_fuzz::defineOptions(conf);
+            char name[] = "miniconf_fuzz_binary";
+            char* argv[] = { name };
+            conf.parse(1, argv);
+            conf["stray.value"] = "stray";
+            std::vector<char> buffer(conf.serialize(nullptr, 0, miniconf::Config::ExportFormat::BINARY) + 1);
+            size_t length = conf.serialize(buffer.data(), buffer.size(), miniconf::Config::ExportFormat::BINARY);
+            content.assign(buffer.data(), length);
+        }
+        return content;
+    }
+}
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size)
+{
+    load(reinterpret_cast<const char*>(data), size);
+
+    std::string content = seed();
+    for (size_t i = 0; i < size && i < content.size(); ++i) {
+        content[i] ^= static_cast<char>(data[i]);
+    }
+    load(content.data(), content.size());
+    return 0;
+}
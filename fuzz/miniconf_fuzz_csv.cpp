@@ -0,0 +1,14 @@
+/*
+ * Fuzz target of the csv loader
+ */
+
+#include "miniconf_fuzz.h"
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size)
+{
+    miniconf::Config conf;
+    miniconf_fuzz::defineOptions(conf);
+    conf.deserialize(miniconf::StringRef(reinterpret_cast<const char*>(data), size), miniconf::Config::ExportFormat::CSV);
+    miniconf_fuzz::touchValues(conf);
+    return 0;
+}
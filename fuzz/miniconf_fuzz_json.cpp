@@ -0,0 +1,18 @@
+/*
+ * Fuzz target of the json loader
+ */
+
+#include "miniconf_fuzz.h"
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size)
+{
+    miniconf::Config conf;
+    miniconf_fuzz::defineOptions(conf);
+#ifdef MINICONF_JSON_SUPPORT
+    conf.deserialize(miniconf::StringRef(reinterpret_cast<const char*>(data), size), miniconf::Config::ExportFormat::JSON);
+#else
+    conf.deserialize(miniconf::StringRef(reinterpret_cast<const char*>(data), size), miniconf::Config::ExportFormat::CSV);
+#endif
+    miniconf_fuzz::touchValues(conf);
+    return 0;
+}
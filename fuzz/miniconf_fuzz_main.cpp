@@ -0,0 +1,49 @@
+/*
+ * Standalone driver of the miniconf fuzz targets
+ *
+ * Runs a fuzz target once for each input file, or for the standard input if no file 
+ * is given. It is linked instead of libFuzzer for AFL (e.g. "afl-fuzz -i corpus -o 
+ * findings -- ./miniconf_fuzz_json @@") and for reproducing a crash.
+ *
+ * usage: miniconf_fuzz_<target> [input files]
+ */
+
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size);
+
+namespace {
+
+    // reads a whole stream
+    std::vector<uint8_t> readAll(FILE* fd)
+    {
+        std::vector<uint8_t> content;
+        uint8_t buffer[4096];
+        size_t n;
+        while ((n = fread(buffer, 1, sizeof(buffer), fd)) > 0) {
+            content.insert(content.end(), buffer, buffer + n);
+        }
+        return content;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    if (argc < 2) {
+        std::vector<uint8_t> input = readAll(stdin);
+        return LLVMFuzzerTestOneInput(input.data(), input.size());
+    }
+    for (int i = 1; i < argc; ++i) {
+        FILE* fd = fopen(argv[i], "rb");
+        if (!fd) {
+            fprintf(stderr, "unable to read %s\n", argv[i]);
+            return 1;
+        }
+        std::vector<uint8_t> input = readAll(fd);
+        fclose(fd);
+        LLVMFuzzerTestOneInput(input.data(), input.size());
+    }
+    return 0;
+}
@@ -22,6 +22,8 @@
  *     Support nested JSON
  * Version 1.5
  *     JSON-less version
+ * Version 1.6
+ *     Small buffer optimization for Value
  *
  */
 
@@ -31,25 +33,547 @@
 /* Comment the line below to disable JSON support */
 #define MINICONF_JSON_SUPPORT
 
+/* Config files are memory-mapped on POSIX systems, otherwise they are read into a buffer */
+#if defined(__unix__) || defined(__APPLE__)
+#define MINICONF_MMAP_SUPPORT
+#endif
+
+/* Config files can be watched for changes via inotify on Linux */
+#if defined(__linux__)
+#define MINICONF_INOTIFY_SUPPORT
+#endif
+
+/* Configs can be published to other processes in POSIX shared memory, see Config::publishShared(),
+ * the segments are synchronized by atomics, which must be lock-free to work across processes */
+#if defined(__unix__) || defined(__APPLE__)
+#include <atomic>
+#if ATOMIC_INT_LOCK_FREE == 2 && ATOMIC_LONG_LOCK_FREE == 2 && ATOMIC_LLONG_LOCK_FREE == 2
+#define MINICONF_SHM_SUPPORT
+#endif
+#endif
+
+/* Uncomment the line below (or define it before including miniconf.h) to load the config
+ * files given to Config::configFiles() on a pool of threads, programs must then be linked 
+ * with the threads library (e.g. -pthread) */
+// #define MINICONF_THREAD_SUPPORT
+
+/* Uncomment the line below (or define it before including miniconf.h) to collect 
+ * timing and allocation statistics of Config::parse() */
+// #define MINICONF_STATS_SUPPORT
+
+/* Uncomment the line below (or define it before including miniconf.h) to allocate 
+ * the loaded values from an arena of large blocks, see Config::arena() */
+// #define MINICONF_ARENA_SUPPORT
+
 #include <string>
 #include <cstring>
+#include <cstdio>
+#include <cmath>
+#include <clocale>
 #include <sstream>
 #include <fstream>
-#include <map>
 #include <vector>
+#include <deque>
+#include <algorithm>
+#include <cstdint>
+#include <cctype>
+#include <limits>
+#include <locale>
+#include <functional>
+#include <memory>
+#include <atomic>
 
 #ifdef MINICONF_JSON_SUPPORT
 #include "picojson.h"
 #endif
 
+#ifdef MINICONF_MMAP_SUPPORT
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+#ifdef MINICONF_SHM_SUPPORT
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+#ifdef MINICONF_INOTIFY_SUPPORT
+#include <poll.h>
+#include <sys/inotify.h>
+#endif
+
+/* The process environment, in which each entry is "NAME=VALUE" */
+#if defined(_WIN32)
+#include <stdlib.h>
+#define MINICONF_ENVIRON _environ
+#elif defined(__APPLE__)
+#include <crt_externs.h>
+#define MINICONF_ENVIRON (*_NSGetEnviron())
+#else
+extern char** environ;
+#define MINICONF_ENVIRON environ
+#endif
+
+#ifdef MINICONF_STATS_SUPPORT
+#include <chrono>
+#define MINICONF_STATS(...) __VA_ARGS__
+#else
+#define MINICONF_STATS(...)
+#endif
+
+#ifdef MINICONF_THREAD_SUPPORT
+#include <thread>
+#endif
+
 namespace miniconf
 {
 
+    /* A non-owning reference to a character buffer
+     *
+     * miniconf::StringRef refers to a string stored elsewhere (e.g. in a Value or an 
+     * Option) without copying it, the referred buffer must outlive the StringRef. The
+     * buffer is not required to be null-terminated.
+     */
+    class StringRef
+    {
+        public:
+
+            // Creates an empty reference
+            StringRef();
+
+            // Refers to a null-terminated char array
+            StringRef(const char* str);
+
+            // Refers to a char buffer of a given length
+            StringRef(const char* str, size_t length);
+
+            // Refers to the buffer of a std::string
+            StringRef(const std::string& str);
+
+            // Gets the pointer to the referred buffer
+            const char* data() const;
+
+            // Gets the number of characters
+            size_t size() const;
+
+            // Checks if the reference is empty
+            bool empty() const;
+
+            // Copies the referred characters to a std::string
+            std::string str() const;
+
+            // Compares the referred characters
+            bool operator==(const StringRef& other) const;
+
+            // Compares the referred characters
+            bool operator!=(const StringRef& other) const;
+
+        private:
+
+            // The referred buffer
+            const char* _data;
+
+            // Number of characters in the buffer
+            size_t _size;
+    };
+
+    /* A non-owning view of an array value
+     *
+     * miniconf::ArrayRef refers to the contiguous elements of an INT_ARRAY, NUMBER_ARRAY or
+     * BOOL_ARRAY value (T is int, double or bool) without copying them. The Value must 
+     * outlive the ArrayRef and must not be modified meanwhile.
+     */
+    template <typename T>
+    class ArrayRef
+    {
+        public:
+
+            // Creates an empty array
+            ArrayRef();
+
+            // Refers to a number of contiguous elements
+            ArrayRef(const T* data, size_t size);
+
+            // Gets the pointer to the first element
+            const T* data() const;
+
+            // Gets the number of elements
+            size_t size() const;
+
+            // Checks if the array is empty
+            bool empty() const;
+
+            // Accesses an element
+            const T& operator[](size_t i) const;
+
+            // Iterators of the elements
+            const T* begin() const;
+            const T* end() const;
+
+            // Copies the elements to a std::vector
+            std::vector<T> vec() const;
+
+        private:
+
+            // The first element
+            const T* _data;
+
+            // Number of elements
+            size_t _size;
+    };
+
+    /* A non-owning view of a STRING_ARRAY value
+     *
+     * The elements are null-terminated strings stored in the buffer of a Value, they
+     * are accessed as StringRefs.
+     */
+    template <>
+    class ArrayRef<StringRef>
+    {
+        public:
+
+            // Iterates over the elements of a string array
+            class const_iterator
+            {
+                public:
+                    const_iterator(const ArrayRef<StringRef>* array, size_t index) : _array(array), _index(index) {}
+                    StringRef operator*() const { return (*_array)[_index]; }
+                    const_iterator& operator++() { ++_index; return *this; }
+                    bool operator==(const const_iterator& other) const { return _index == other._index; }
+                    bool operator!=(const const_iterator& other) const { return _index != other._index; }
+                private:
+                    const ArrayRef<StringRef>* _array;
+                    size_t _index;
+            };
+
+            // Creates an empty array
+            ArrayRef();
+
+            // Gets the number of elements
+            size_t size() const;
+
+            // Checks if the array is empty
+            bool empty() const;
+
+            // Accesses an element
+            StringRef operator[](size_t i) const;
+
+            // Iterators of the elements
+            const_iterator begin() const;
+            const_iterator end() const;
+
+            // Copies the elements to a std::vector
+            std::vector<std::string> vec() const;
+
+        private:
+
+            friend class Value;
+
+            // Refers to the string array layout of a Value buffer
+            explicit ArrayRef(const char* buffer);
+
+            /* The referred buffer
+             *
+             * It holds the number of elements, the offsets of the elements and one past
+             * the last element (uint32_t each), followed by the characters.
+             */
+            const char* _buffer;
+
+            // Number of elements
+            size_t _size;
+    };
+
+    /* Read-only content of a file
+     *
+     * A FileBuffer maps a file into memory when MINICONF_MMAP_SUPPORT is defined, 
+     * otherwise the whole file is read into a buffer at once. The content is released
+     * when the FileBuffer is destroyed, so references to it must not outlive the 
+     * FileBuffer. An empty content is provided if the file cannot be read.
+     */
+    class FileBuffer
+    {
+        public:
+
+            // Opens and reads (or maps) a file
+            explicit FileBuffer(const std::string& path);
+
+            // Releases the file content
+            ~FileBuffer();
+
+            // Checks if the file has been read successfully
+            bool good() const;
+
+            // Gets the content of the file
+            StringRef content() const;
+
+        private:
+
+            // A FileBuffer owns its content and cannot be copied
+            FileBuffer(const FileBuffer& other);
+            FileBuffer& operator=(const FileBuffer& other);
+
+            // Pointer to the file content
+            const char* _data;
+
+            // Size of the file content
+            size_t _size;
+
+            // Checks if the file has been read successfully
+            bool _good;
+
+            // Checks if the content is memory-mapped
+            bool _mapped;
+
+            // Buffer of the content when it is not memory-mapped
+            std::vector<char> _buffer;
+    };
+
+    /* Change notifications of a file
+     *
+     * A FileWatcher blocks until a file is written or replaced (e.g. saved by an editor
+     * via rename), so a config file can be reloaded without polling. The directory of
+     * the file is watched with inotify when MINICONF_INOTIFY_SUPPORT is defined, 
+     * otherwise the watcher is not supported and good() returns false.
+     */
+    class FileWatcher
+    {
+        public:
+
+            // Starts watching a file
+            explicit FileWatcher(const std::string& path);
+
+            // Stops watching the file
+            ~FileWatcher();
+
+            // Checks if the file is being watched
+            bool good() const;
+
+            // Gets the file descriptor of the watcher for poll() / select(), -1 if unsupported
+            int fd() const;
+
+            /* Waits for the file to change
+             *
+             * @timeout Maximum waiting time in milliseconds, a negative value waits forever
+             * @return True if the file has changed, False on timeout or error
+             */
+            bool wait(int timeout = -1);
+
+        private:
+
+            // A FileWatcher owns its descriptor and cannot be copied
+            FileWatcher(const FileWatcher& other);
+            FileWatcher& operator=(const FileWatcher& other);
+
+            // The inotify descriptor
+            int _fd;
+
+            // Name of the watched file within its directory
+            std::string _name;
+    };
+
+    /* Output of the serializers
+     *
+     * A Writer streams characters to a FILE*, appends them to a std::string, or copies 
+     * them into a fixed-size buffer, so serialized output does not need to be built in
+     * memory first. A buffer is always left with room for a terminating null character,
+     * the output is truncated if it does not fit.
+     */
+    class Writer
+    {
+        public:
+
+            // Writes to a file stream
+            explicit Writer(FILE* fd);
+
+            // Appends to a string
+            explicit Writer(std::string& out);
+
+            // Writes into a buffer of a given size
+            Writer(char* buffer, size_t size);
+
+            // Writes a number of characters
+            void write(const char* data, size_t size);
+
+            // Writes the referred characters
+            void write(const StringRef& str);
+
+            // Writes a character
+            void put(char c);
+
+            // Null-terminates the buffer
+            void terminate();
+
+            // Gets the number of characters written, including the truncated ones
+            size_t size() const;
+
+            // Checks if all the characters have been written
+            bool good() const;
+
+        private:
+
+            // The output file stream
+            FILE* _fd;
+
+            // The output string
+            std::string* _string;
+
+            // The output buffer
+            char* _buffer;
+
+            // Size of the output buffer
+            size_t _capacity;
+
+            // Number of characters written
+            size_t _size;
+
+            // Checks if all the characters have been written
+            bool _good;
+    };
+
+    /* Locale-independent number parsing
+     *
+     * miniconf::NumberParser converts decimal text to numbers regardless of the global
+     * C/C++ locale, it is shared by the command line, CSV and JSON loaders. The whole
+     * token (apart from surrounding whitespaces) must be a number, partial parses such
+     * as "12abc" are rejected. Floating point numbers which can be represented exactly
+     * are computed directly, others are delegated to a classic-locale stream.
+     */
+    class NumberParser
+    {
+        public:
+
+            // Parses a decimal integer, returns false if the token is not an int
+            static bool parseInt(const StringRef& token, int& value);
+
+            // Parses a floating point number, returns false if the token is not a number
+            static bool parseNumber(const StringRef& token, double& value);
+
+            // Converts a number to an int, returns false if it has a fraction or is out of the int range
+            static bool toInt(double number, int& value);
+
+        private:
+
+            // Removes leading and trailing whitespaces from a token
+            static void trim(const char*& first, const char*& last);
+
+            // Checks if a token equals a lowercase word, case insensitive
+            static bool matchWord(const char* first, const char* last, const char* word);
+    };
+
+    /* A copyable atomic counter
+     *
+     * std::atomic cannot be copied, copying an AtomicCounter copies its current value
+     * instead, so the objects holding one remain copyable.
+     */
+    class AtomicCounter
+    {
+        public:
+
+            // Creates a counter with an initial value
+            explicit AtomicCounter(size_t value = 0);
+
+            // Copies the current value of another counter
+            AtomicCounter(const AtomicCounter& other);
+
+            // Assigns the current value of another counter
+            AtomicCounter& operator=(const AtomicCounter& other);
+
+            // Reads the counter
+            size_t load(std::memory_order order = std::memory_order_seq_cst) const;
+
+            // Writes the counter
+            void store(size_t value, std::memory_order order = std::memory_order_seq_cst);
+
+        private:
+
+            // The counter value
+            std::atomic<size_t> _value;
+    };
+
+#ifdef MINICONF_STATS_SUPPORT
+    // A wall clock timer for measuring phases of an operation
+    class StopWatch
+    {
+        public:
+
+            // Starts the timer
+            StopWatch();
+
+            // Gets the seconds elapsed since the timer was started or the last lap, and starts a new lap
+            double lap();
+
+        private:
+
+            // Start time of the current lap
+            std::chrono::steady_clock::time_point _start;
+    };
+
+    // Number and size of heap allocations
+    struct AllocationStats {
+        size_t count;       // number of allocations
+        size_t bytes;       // allocated bytes
+    };
+#endif
+
+#ifdef MINICONF_ARENA_SUPPORT
+    /* A monotonic arena of memory blocks
+     *
+     * Buffers are carved from large blocks and never freed one by one, all the blocks
+     * are released at once by the destructor. While an arena is active on a thread,
+     * the Value buffers which do not fit into the inline buffer are allocated from it.
+     */
+    class Arena
+    {
+        public:
+
+            // Creates an empty arena, blocks are allocated on demand
+            explicit Arena(size_t blockSize);
+
+            // Allocates a buffer aligned for double, large buffers get their own block
+            char* allocate(size_t size);
+
+            // Gets the number of bytes allocated from the arena
+            size_t used() const;
+
+            // Gets the arena of the current thread, or nullptr if Values are allocated on the heap
+            static Arena* active();
+
+            // Activates an arena (or the heap, for nullptr) on the current thread, returns the previous one
+            static Arena* activate(Arena* arena);
+
+        private:
+
+            // Gets the storage of the active arena of the current thread
+            static Arena*& current();
+
+            // Size of the regular blocks
+            size_t _blockSize;
+
+            // The allocated blocks
+            std::vector<std::unique_ptr<char[]> > _blocks;
+
+            // Next free byte of the current block
+            char* _position;
+
+            // Number of free bytes in the current block
+            size_t _remaining;
+
+            // Number of allocated bytes
+            size_t _used;
+    };
+#endif
+
     /* A flexible container for multiple data type
      *
      * miniconf::Value is a flexible container for int, double, bool and char array. The 
-     * actual value is stored in a buffer declared during assignment. An extra "unknown"
-     * type is also defined for empty, or invalid value. 
+     * actual value is stored in a small inline buffer, only strings which do not fit into
+     * the inline buffer are allocated on the heap. An extra "unknown" type is also defined
+     * for empty, or invalid value. 
      */
     class Value
     {
@@ -61,7 +585,12 @@ namespace miniconf
                 INT,
                 NUMBER,
                 BOOL,
-                STRING
+                STRING,
+                INT_ARRAY,
+                NUMBER_ARRAY,
+                BOOL_ARRAY,
+                STRING_ARRAY,
+                CHOICE
             };
 
             /* Default constructors and assignments for Value, "unknown" type is assigned
@@ -99,6 +628,40 @@ namespace miniconf
             
             // Constructs a Value instance from a std::string
             explicit Value(const std::string& other);
+
+            // Constructs a Value instance from a referred string
+            explicit Value(const StringRef& other);
+
+            // Constructs an array Value instance from integers
+            explicit Value(const std::vector<int>& other);
+
+            // Constructs an array Value instance from floating point numbers
+            explicit Value(const std::vector<double>& other);
+
+            // Constructs an array Value instance from booleans
+            explicit Value(const std::vector<bool>& other);
+
+            // Constructs an array Value instance from strings
+            explicit Value(const std::vector<std::string>& other);
+
+            // Constructs an array Value instance from referred strings
+            explicit Value(const std::vector<StringRef>& other);
+
+            // Constructs an array Value instance from referred integers
+            explicit Value(const ArrayRef<int>& other);
+
+            // Constructs an array Value instance from referred floating point numbers
+            explicit Value(const ArrayRef<double>& other);
+
+            // Constructs an array Value instance from referred booleans
+            explicit Value(const ArrayRef<bool>& other);
+
+            /* Constructs a CHOICE value from the index of the choice and its name
+             *
+             * getInt() gets the index, -1 for a name which is not a choice of the option,
+             * getStringRef() and print() get the name.
+             */
+            static Value choice(int index, const StringRef& name);
            
             // Assigns an integer to a Value instance
             Value& operator=(const int& other);
@@ -114,6 +677,9 @@ namespace miniconf
             
             // Assigns a std::string to a Value instance
             Value& operator=(const std::string& other);
+
+            // Assigns a referred string to a Value instance
+            Value& operator=(const StringRef& other);
            
             // Casts a Value to an integer
             explicit operator int() const;
@@ -145,53 +711,635 @@ namespace miniconf
             // Explicitly gets a std::string from a Value instance
             std::string getString() const;
 
+            // Gets a reference to the string stored in a Value instance without copying it
+            StringRef getStringRef() const;
+
+            // Gets the elements of an INT_ARRAY value, empty for other types
+            ArrayRef<int> getIntArray() const;
+
+            // Gets the elements of a NUMBER_ARRAY value, empty for other types
+            ArrayRef<double> getNumberArray() const;
+
+            // Gets the elements of a BOOL_ARRAY value, empty for other types
+            ArrayRef<bool> getBooleanArray() const;
+
+            // Gets the elements of a STRING_ARRAY value, empty for other types
+            ArrayRef<StringRef> getStringArray() const;
+
+            // Gets the number of elements of an array value, 0 for other types
+            size_t arraySize() const;
+
+            // Gets an element of an array value as a scalar Value
+            Value element(size_t i) const;
+
+            // Checks if the value is an array
+            bool isArray() const;
+
+            // Gets the element type of an array type, or UNKNOWN
+            static DataType elementType(DataType arrayType);
+
+            // Gets the array type of an element type, or UNKNOWN
+            static DataType arrayType(DataType elementType);
+
             // Serializes the value to a string
-            std::string print();
+            std::string print() const;
 
             // Serializes the data type of the current value to a string, mainly for debugging purpose
-            std::string printType();
+            std::string printType() const;
 
             // Gets the data type of the current value
-            DataType type();
+            DataType type() const;
+
+            // Checks if two values have the same data type and content
+            bool operator==(const Value& other) const;
+
+            // Checks if two values differ in data type or content
+            bool operator!=(const Value& other) const;
 
             // Checks if the value is empty (unknown)
-            bool isEmpty();
+            bool isEmpty() const;
 
             // Generates an unknown (empty) Value object
             static Value unknown();
 
+#ifdef MINICONF_STATS_SUPPORT
+            // Gets the heap allocations of Value objects made by the current thread
+            static AllocationStats& allocationStats();
+#endif
+
         private:
 
-            // Moves value data from a pointer
-            Value& moveData(char*& src, const size_t size, const DataType type);
+            /* Number of bytes which can be stored without heap allocation
+             *
+             * INT, NUMBER, BOOL, short STRING values (including the terminating
+             * null character) and CHOICE values of short names are stored in the 
+             * inline buffer, only long strings are allocated on the heap.
+             */
+            static const size_t INLINE_SIZE = 24;
+
+            // Moves value data from another Value instance, the other instance becomes empty
+            Value& moveData(Value& other);
 
             // Copies value data from a pointer
             Value& copyData(const char* src, const size_t size, const DataType& type);
 
+            // Copies a string which is not null-terminated, a terminating null character is appended
+            Value& copyString(const char* src, const size_t length);
+
+            // Copies strings into the string array layout
+            template <typename Iter>
+            Value& copyStrings(Iter first, Iter last);
+
+            // Allocates a buffer for a value which does not fit into the inline buffer,
+            // from the active arena or from the heap, the previous buffer must be released
+            char* allocate(size_t size);
+
+            // Checks if the buffer can be taken over by another value
+            bool movable() const;
+
             // Clears allocated value data
             void clearData();
 
+            // Checks if the value is stored in the inline buffer
+            bool isInline() const;
+
             // It stores the data type of the current value
             DataType _type;
 
-            // Number of bytes allocated to the buffer
+            // Number of bytes used by the value
             size_t _size;
 
-            // The pointer to the value buffer
+            // The pointer to the value buffer, points to _buffer for inline values
             char* _data;
+
+#ifdef MINICONF_ARENA_SUPPORT
+            // Checks if the buffer belongs to an arena, so it is not freed
+            bool _arena;
+#endif
+
+            // Inline buffer for small values, aligned for double
+            union {
+                double _alignment;
+                char _buffer[INLINE_SIZE];
+            };
     };
 
-    /*
-     * A Config object describes the configuration settings of an 
-     * application. It contains a list of options which can be parsed from 
-     * program arguments or from a configuration file (e.g. JSON).
+    /* Compile-time mapping from C++ types to Value data types
      *
-     * Configuration options are defined via the Config class's API. The
-     * data type of each option is determined during compile time. User
-     * can modify the values of the configuration options during run-time.
-     * An option is invoked by a option flag, e.g. "--option" or "-o" in 
-     * the command line arguments, or their corresponding attribute values
-     * in a configuration file. Configuration file support can also be 
+     * ValueTraits is defined for int, double, bool, std::string and StringRef. Typed 
+     * accessors (e.g. Config::Handle) do not compile with other types. get() checks 
+     * the data type of a Value and returns a default value on mismatch instead of 
+     * reinterpreting the buffer. A CHOICE value is read as an int (the index of the
+     * choice) or as a string (its name).
+     */
+    template <typename T>
+    struct ValueTraits;
+
+    template <>
+    struct ValueTraits<int>
+    {
+        static Value::DataType type() { return Value::DataType::INT; }
+        static int get(const Value& v) { return (v.type() == type() || v.type() == Value::DataType::CHOICE) ? v.getInt() : 0; }
+    };
+
+    template <>
+    struct ValueTraits<double>
+    {
+        static Value::DataType type() { return Value::DataType::NUMBER; }
+        static double get(const Value& v) { return (v.type() == type()) ? v.getNumber() : 0.0; }
+    };
+
+    template <>
+    struct ValueTraits<bool>
+    {
+        static Value::DataType type() { return Value::DataType::BOOL; }
+        static bool get(const Value& v) { return (v.type() == type()) ? v.getBoolean() : false; }
+    };
+
+    template <>
+    struct ValueTraits<std::string>
+    {
+        static Value::DataType type() { return Value::DataType::STRING; }
+        static std::string get(const Value& v) { return v.getStringRef().str(); }
+    };
+
+    template <>
+    struct ValueTraits<StringRef>
+    {
+        static Value::DataType type() { return Value::DataType::STRING; }
+        static StringRef get(const Value& v) { return v.getStringRef(); }
+    };
+
+    template <>
+    struct ValueTraits<ArrayRef<int> >
+    {
+        static Value::DataType type() { return Value::DataType::INT_ARRAY; }
+        static ArrayRef<int> get(const Value& v) { return v.getIntArray(); }
+    };
+
+    template <>
+    struct ValueTraits<ArrayRef<double> >
+    {
+        static Value::DataType type() { return Value::DataType::NUMBER_ARRAY; }
+        static ArrayRef<double> get(const Value& v) { return v.getNumberArray(); }
+    };
+
+    template <>
+    struct ValueTraits<ArrayRef<bool> >
+    {
+        static Value::DataType type() { return Value::DataType::BOOL_ARRAY; }
+        static ArrayRef<bool> get(const Value& v) { return v.getBooleanArray(); }
+    };
+
+    template <>
+    struct ValueTraits<ArrayRef<StringRef> >
+    {
+        static Value::DataType type() { return Value::DataType::STRING_ARRAY; }
+        static ArrayRef<StringRef> get(const Value& v) { return v.getStringArray(); }
+    };
+
+    // Slot number returned when a flag is not found
+    const size_t NO_SLOT = static_cast<size_t>(-1);
+
+    /* A hash index of flags
+     *
+     * A FlagIndex maps flags to slot numbers using open addressing. The flags
+     * themselves are not stored in the index, each lookup provides a function which
+     * gets the flag of a slot, so the index stays valid when the flag buffers are 
+     * moved or the owner is copied. Lookups take a StringRef, so no string is 
+     * constructed for each command line token or config key.
+     */
+    class FlagIndex
+    {
+        public:
+
+            // Creates an empty index
+            FlagIndex();
+
+            // Removes all entries and reserves space for a number of entries
+            void reset(size_t count);
+
+            /* Finds the slot of a flag
+             *
+             * @keyOf A function which returns the flag (StringRef) of a slot
+             * @return The slot of the flag, or NO_SLOT
+             */
+            template <typename KeyOf>
+            size_t find(const StringRef& flag, const KeyOf& keyOf) const;
+
+            /* Inserts the slot of a flag
+             *
+             * @keyOf A function which returns the flag (StringRef) of a slot
+             * @return The slot previously inserted with the same flag, or NO_SLOT
+             */
+            template <typename KeyOf>
+            size_t insert(const StringRef& flag, size_t slot, const KeyOf& keyOf);
+
+            // Finds the slot of a flag with a precomputed hash
+            template <typename KeyOf>
+            size_t find(const StringRef& flag, uint64_t hash, const KeyOf& keyOf) const;
+
+            // Inserts the slot of a flag with a precomputed hash
+            template <typename KeyOf>
+            size_t insert(const StringRef& flag, uint64_t hash, size_t slot, const KeyOf& keyOf);
+
+            // FNV-1a hash of a flag, equal to Schema::hash()
+            static uint64_t hash(const StringRef& flag);
+
+        private:
+
+            // An entry of the hash table, an entry of NO_SLOT is empty
+            struct Entry {
+                uint64_t hash;
+                size_t slot;
+            };
+
+            // Finds the entry of a flag, or the empty entry where it should be inserted
+            template <typename KeyOf>
+            size_t probe(const StringRef& flag, uint64_t hash, const KeyOf& keyOf) const;
+
+            // The hash table, size is always a power of two
+            std::vector<Entry> _entries;
+
+            // Number of occupied entries
+            size_t _count;
+    };
+
+    /* A prefix trie of command line words, e.g. "--flag" and "-f", for shell completion
+     *
+     * The words are sorted, so the words below a node form a contiguous range, and
+     * chains of single children are merged into one node. A prefix is resolved in 
+     * O(prefix length) into the range of words starting with it. A trie can be saved
+     * into a compact binary file and loaded without a Config, e.g. by a completion helper.
+     */
+    class FlagTrie
+    {
+        public:
+
+            // Creates an empty trie
+            FlagTrie();
+
+            // Builds the trie of a list of words, duplicates are removed
+            void build(std::vector<std::string> words);
+
+            // Gets the number of words
+            size_t size() const;
+
+            // Gets a word in sorted order
+            StringRef word(size_t i) const;
+
+            // Gets the range [first, last) of the words starting with a prefix
+            std::pair<size_t, size_t> find(const StringRef& prefix) const;
+
+            /* Completes a prefix to the words starting with it
+             *
+             * Words which continue with further dotted segments are merged into their
+             * next segment, e.g. "--part2.sub" is completed to "--part2.subpart1." if 
+             * several flags start with it.
+             */
+            std::vector<std::string> complete(const StringRef& prefix) const;
+
+            // Serializes the trie into its binary layout
+            std::string serialize() const;
+
+            // Loads the binary layout of a trie, returns false if it is invalid
+            bool deserialize(const StringRef& content);
+
+            // Saves the trie into a binary file
+            bool save(const std::string& path) const;
+
+            // Loads the trie from a binary file
+            bool load(const std::string& path);
+
+        private:
+
+            /* A node of the trie, the children of a node are stored next to each other
+             * and sorted by their first character. The node stands for the first depth
+             * characters of its words, which are shared by all of them.
+             */
+            struct Node {
+                uint32_t firstChild;
+                uint32_t childCount;
+                uint32_t first;         // the first word below the node
+                uint32_t last;          // one past the last word below the node
+                uint32_t depth;         // length of the prefix of the node
+            };
+
+            // The header of the binary layout, followed by the nodes, the word offsets and the characters
+            struct Header {
+                char magic[8];          // "MINITRIE"
+                uint32_t version;       // format version
+                uint32_t byteOrder;     // byte order check value in the writer's byte order
+                uint32_t nodeCount;
+                uint32_t wordCount;
+                uint32_t charsSize;
+                uint32_t reserved;
+            };
+
+            // Builds the children of a node
+            void buildChildren(size_t node);
+
+            // Gets a character of a word
+            unsigned char at(size_t word, size_t i) const;
+
+            // Nodes, the root is the first node
+            std::vector<Node> _nodes;
+
+            // Offsets of the words in _chars, with the end of the last word
+            std::vector<uint32_t> _offsets;
+
+            // Characters of the sorted words
+            std::string _chars;
+    };
+
+    /* Flat storage of options and their values
+     *
+     * A FlatTable assigns each flag a slot. The flags are interned in one character 
+     * arena, and the options and the values are stored in two columns indexed by 
+     * the same slot, so a full sweep over the values never touches the options. A
+     * slot holds an option, a value, both (the normal case), or neither after they 
+     * have been removed. Slots are never reused for other flags, so slot numbers
+     * stay valid until clear().
+     *
+     * The columns are std::deque, which keeps references to options and values 
+     * valid when new slots are added, as Config::option() and Config::operator[]
+     * return references. Slots are iterated in flag order through options() and
+     * values(), which are sorted lazily after slots are added or removed.
+     */
+    template <typename O>
+    class FlatTable
+    {
+        public:
+
+            // Creates an empty table
+            FlatTable();
+
+            // Gets the number of slots
+            size_t size() const;
+
+            // Removes all slots
+            void clear();
+
+            // Finds the slot of a flag, returns NO_SLOT if the flag has no slot
+            size_t find(const StringRef& flag) const;
+
+            // Finds the slot of a flag, a new slot is created if necessary
+            size_t insert(const StringRef& flag);
+
+            // Finds or creates the slot of a flag with a precomputed hash (see FlagIndex::hash())
+            size_t insert(const StringRef& flag, uint64_t hash);
+
+            // Gets the flag of a slot, the referred buffer is null-terminated
+            StringRef key(size_t slot) const;
+
+            // Checks if a slot holds an option
+            bool hasOption(size_t slot) const;
+
+            // Checks if a slot holds a value
+            bool hasValue(size_t slot) const;
+
+            // Adds or removes the option of a slot, a removed option is reset
+            void setOption(size_t slot, bool present);
+
+            // Adds or removes the value of a slot, a removed value is reset
+            void setValue(size_t slot, bool present);
+
+            // Gets the option of a slot
+            O& option(size_t slot);
+
+            // Gets the option of a slot
+            const O& option(size_t slot) const;
+
+            // Gets the value of a slot
+            Value& value(size_t slot);
+
+            // Gets the value of a slot
+            const Value& value(size_t slot) const;
+
+            // Finds the slot of a flag holding an option, or returns NO_SLOT
+            size_t findOption(const StringRef& flag) const;
+
+            // Finds the slot of a flag holding a value, or returns NO_SLOT
+            size_t findValue(const StringRef& flag) const;
+
+            /* Gets the slots holding an option, sorted by flag
+             *
+             * The returned list is rebuilt after options are added or removed, so it
+             * must not be used while options are added or removed.
+             */
+            const std::vector<size_t>& options();
+
+            /* Gets the slots holding a value, sorted by flag
+             *
+             * The returned list is rebuilt after values are added or removed, so it
+             * must not be used while values are added or removed.
+             */
+            const std::vector<size_t>& values();
+
+        private:
+
+            // Presence flags of a slot
+            enum Presence {
+                HAS_OPTION = 1,
+                HAS_VALUE = 2
+            };
+
+            // Location of a flag in the arena
+            struct Key {
+                size_t offset;
+                size_t length;
+            };
+
+            // Sorts the slots created since the last call
+            void sortSlots();
+
+            // Collects the sorted slots with a presence flag
+            void collect(std::vector<size_t>& slots, unsigned char presence);
+
+            // The arena of null-terminated flags
+            std::vector<char> _arena;
+
+            // Flag of each slot
+            std::vector<Key> _keys;
+
+            // Presence flags of each slot
+            std::vector<unsigned char> _presence;
+
+            // Option of each slot
+            std::deque<O> _options;
+
+            // Value of each slot
+            std::deque<Value> _values;
+
+            // Hash index from flags to slots
+            FlagIndex _index;
+
+            // All slots sorted by flag
+            std::vector<size_t> _sorted;
+
+            // Sorted slots holding an option
+            std::vector<size_t> _optionSlots;
+
+            // Sorted slots holding a value
+            std::vector<size_t> _valueSlots;
+
+            // Checks if _optionSlots is up-to-date
+            bool _optionSlotsValid;
+
+            // Checks if _valueSlots is up-to-date
+            bool _valueSlotsValid;
+    };
+
+    /* A layer of values from one source, e.g. a config file or runtime overrides
+     *
+     * A layer only stores the values defined by its source, identified by the slots of
+     * a FlatTable. Values are appended and sorted by slot when they are looked up, a 
+     * later value of a slot replaces an earlier one. The values are shared by copies of
+     * the layer and by snapshots, and copied before a shared layer is modified.
+     */
+    class ValueLayer
+    {
+        public:
+
+            // Values and their slots
+            typedef std::vector<std::pair<size_t, Value> > Values;
+
+            // Creates an empty layer
+            explicit ValueLayer(const std::string& name);
+
+            // Gets the name of the layer
+            const std::string& name() const;
+
+            // Adds a value of a slot, the reference is valid until the next value is added
+            Value& set(size_t slot);
+
+            // Finds the value of a slot, returns nullptr if the layer does not define it
+            const Value* find(size_t slot);
+
+            // Removes all values
+            void clear();
+
+#ifdef MINICONF_ARENA_SUPPORT
+            // Copies each value into a new buffer, allocated from the active arena or the heap
+            void copyValues();
+#endif
+
+            // Gets the values sorted by slot, they are not modified afterwards
+            std::shared_ptr<const Values> share();
+
+            // Finds the value of a slot in values sorted by share(), returns nullptr if not found
+            static const Value* find(const Values& values, size_t slot);
+
+        private:
+
+            // Sorts the values added since the last lookup, keeping the last value of each slot
+            void sort();
+
+            // Copies the values before they are modified if they are shared
+            void own();
+
+            // Name of the layer
+            std::string _name;
+
+            // Values and their slots
+            std::shared_ptr<Values> _values;
+
+            // Number of values at the beginning of _values which are sorted
+            size_t _sortedCount;
+    };
+
+    /* A compile-time description of an option
+     *
+     * A schema is a constexpr array of OptionSpec with static storage duration. It is
+     * checked at compile time by MINICONF_CHECK_SCHEMA and registered at once by
+     * Config::schema(). The data type is selected by the type of the default value,
+     * the hashes of the flags are precomputed for the checks and the flag index.
+     */
+    struct OptionSpec
+    {
+        constexpr OptionSpec(const char* flag, const char* shortflag, int defaultValue, const char* description, bool required = false);
+        constexpr OptionSpec(const char* flag, const char* shortflag, double defaultValue, const char* description, bool required = false);
+        constexpr OptionSpec(const char* flag, const char* shortflag, bool defaultValue, const char* description, bool required = false);
+        constexpr OptionSpec(const char* flag, const char* shortflag, const char* defaultValue, const char* description, bool required = false);
+
+        const char* flag;
+        const char* shortflag;
+        const char* description;
+        Value::DataType type;
+        int intValue;
+        double numberValue;
+        bool boolValue;
+        const char* stringValue;
+        bool required;
+        uint64_t hash;
+        uint64_t shortflagHash;
+    };
+
+    /* Compile-time checks of a schema (an array of OptionSpec)
+     *
+     * Pairs of options are compared by halving the ranges, so the recursion
+     * depth only grows logarithmically with the size of the schema.
+     */
+    class Schema
+    {
+        public:
+
+            // Checks if the flags are non-empty and unique
+            template <size_t N>
+            static constexpr bool uniqueFlags(const OptionSpec (&specs)[N]);
+
+            // Checks if the non-empty short flags are unique
+            template <size_t N>
+            static constexpr bool uniqueShortflags(const OptionSpec (&specs)[N]);
+
+            // Checks if every option has a default value, i.e. no string default is a nullptr
+            template <size_t N>
+            static constexpr bool defaultsDefined(const OptionSpec (&specs)[N]);
+
+            // FNV-1a hash of a null-terminated flag, equal to FlagIndex::hash()
+            static constexpr uint64_t hash(const char* flag, uint64_t h = 14695981039346656037ULL);
+
+        private:
+
+            // Compares two null-terminated strings
+            static constexpr bool equal(const char* a, const char* b);
+
+            // Gets the flag or the short flag of an option, a nullptr is read as ""
+            static constexpr const char* key(const OptionSpec& spec, bool shortflag);
+
+            // Checks if the keys of the options [first, last) are unique
+            static constexpr bool distinct(const OptionSpec* specs, size_t first, size_t last, bool shortflag);
+
+            // Checks if no key of the options [first, last) equals a key of the options [first2, last2)
+            static constexpr bool disjoint(const OptionSpec* specs, size_t first, size_t last, size_t first2, size_t last2, bool shortflag);
+
+            // Checks if the key of the i-th option differs from the keys of the options [first, last)
+            static constexpr bool excluded(const OptionSpec* specs, size_t i, size_t first, size_t last, bool shortflag);
+
+            // Checks if the keys of two options differ
+            static constexpr bool unequal(const OptionSpec& a, const OptionSpec& b, bool shortflag);
+
+            // Checks if the options [first, last) have non-empty flags and default values
+            static constexpr bool defined(const OptionSpec* specs, size_t first, size_t last, bool flags);
+    };
+
+// Checks a schema at compile time, the schema must be a constexpr array of OptionSpec
+#define MINICONF_CHECK_SCHEMA(specs) \
+    static_assert(miniconf::Schema::uniqueFlags(specs), "miniconf schema: empty or duplicate flag"); \
+    static_assert(miniconf::Schema::uniqueShortflags(specs), "miniconf schema: duplicate short flag"); \
+    static_assert(miniconf::Schema::defaultsDefined(specs), "miniconf schema: option without a default value")
+
+    /*
+     * A Config object describes the configuration settings of an 
+     * application. It contains a list of options which can be parsed from 
+     * program arguments or from a configuration file (e.g. JSON).
+     *
+     * Configuration options are defined via the Config class's API. The
+     * data type of each option is determined during compile time. User
+     * can modify the values of the configuration options during run-time.
+     * An option is invoked by a option flag, e.g. "--option" or "-o" in 
+     * the command line arguments, or their corresponding attribute values
+     * in a configuration file. Configuration file support can also be 
      * disabled manually.
      *
      * Basic sanity checks, such as default values and format checks are 
@@ -223,19 +1371,93 @@ namespace miniconf
                 NONE
             };
 
+            /* Identifies a log message
+             *
+             * Each code has a fixed message text, see Config::logMessage().
+             */
+            enum class LogCode {
+                DEFAULT_VALUE_UNDEFINED,    // an optional option has no default value
+                DUPLICATE_SHORTFLAG,        // a short flag is used by another option, detail: the short flag
+                NO_DESCRIPTION,             // an option has no description
+                NO_SHORTFLAG,               // an option has no short flag
+                NO_PROGRAM_DESCRIPTION,     // the program has no description
+                INVALID_VALUE,              // an option value is invalid after parsing
+                UNDEFINED_OPTION,           // a required option has no value
+                INVALID_VALUE_TYPE,         // an argument cannot be parsed as the option type
+                VALUE_PARSED,               // an argument is parsed
+                UNKNOWN_INPUT,              // an argument is not a flag or a value
+                UNRECOGNIZED_FLAG,          // a flag is not defined
+                UNASSOCIATED_ARGUMENT,      // a value does not follow a flag
+                HANDLE_TYPE_MISMATCH,       // a handle is created with a different type than the option
+                CONFIG_UNREADABLE,          // a config file cannot be read
+                NOTHING_TO_RELOAD,          // reload() is called before a config file is loaded
+                RELOAD_FAILED,              // reloading a config file failed
+                VALUE_RELOADED,             // a value is changed by reload()
+                BINARY_VERSION,             // a binary config has an unsupported version
+                BINARY_BYTE_ORDER,          // a binary config has a different byte order
+                BINARY_CORRUPTED,           // a binary config is truncated or corrupted
+                BINARY_SCHEMA_MISMATCH,     // a binary config is written with different options
+                BINARY_INVALID_FLAG,        // a binary config contains an invalid flag
+                BINARY_INVALID_ARRAY,       // a binary config contains an invalid array
+                BINARY_INVALID_STRING,      // a binary config contains an invalid string
+                BINARY_UNSUPPORTED_TYPE,    // a binary config contains an unsupported value type
+                BINARY_TYPE_MISMATCH,       // a binary config value differs from the option type
+                VALUE_LOADED,               // a value is loaded from a config file
+                STRAY_VALUE_LOADED,         // an undefined value is loaded from a config file
+                STRAY_VALUE_AS_STRING,      // an undefined value is loaded from a csv file as a string
+                CONFIG_VALUE_INVALID,       // a config file value cannot be parsed
+                CONFIG_VALUE_TYPE_MISMATCH, // a config file value differs from the option type, detail: the flag
+                CONFIG_ARRAY_INVALID,       // a config file array cannot be parsed
+                JSON_INVALID,               // a json config cannot be parsed, detail: the parser error
+                JSON_TOO_DEEP,              // a json config is nested deeper than the limit, detail: the limit
+                JSON_TOO_LARGE,             // a json config is larger than the limit, detail: the limit
+                ENVIRONMENT_VALUE_LOADED,   // a value is loaded from an environment variable
+                ENVIRONMENT_VALUE_INVALID,  // an environment variable cannot be parsed as the option type
+                ENVIRONMENT_NAME_COLLISION, // two options map to the same environment variable, detail: the option which is loaded
+                INVALID_CHOICE,             // a value is not one of the choices of the option, detail: the choices
+                SHARED_UNAVAILABLE,         // a shared memory segment cannot be written, detail: the system error
+                SHARED_PUBLISHED            // the values are published into a shared memory segment
+            };
+
+            /* A structured log message
+             *
+             * The token and the detail refer to buffers owned by the Config object (or the
+             * caller), they are only valid during the call of a log sink or a log reader.
+             */
+            struct LogRecord {
+                LogLevel level;             // severity of the message
+                LogCode code;               // identifies the message
+                StringRef token;            // the input token, e.g. an argument or a flag
+                StringRef detail;           // the variable part of the message, empty for most codes
+            };
+
+            /* Receiver of log messages
+             *
+             * A sink is called for each message which is not filtered by the log level, 
+             * formatting is left to the sink, e.g. with Config::formatLog().
+             */
+            typedef std::function<void(const LogRecord& record)> LogSink;
+
             /* File format for serialization 
              *
              * User can either serialize the current configuration, or 
              * write one config file manually using external editors.
+             * BINARY is a compact format for loading a resolved configuration 
+             * quickly, e.g. by many short-lived processes. It consists of a
+             * header, typed value slots and a string table, and is recognized
+             * by its header regardless of the file extension. Binary files are 
+             * not portable between platforms of different byte orders.
              */
 #ifdef MINICONF_JSON_SUPPORT
             enum class ExportFormat {
                 JSON,
-                CSV
+                CSV,
+                BINARY
             };
 #else
             enum class ExportFormat {
-                CSV
+                CSV,
+                BINARY
             };
 #endif
 
@@ -251,6 +1473,79 @@ namespace miniconf
              */
             class Option;
 
+            /* A typed handle of an option value
+             *
+             * A handle is created once by Config::handle<T>(flag) and holds the slot of 
+             * the flag, so Config::get() reads the value with an indexed load, without a
+             * flag lookup. T is one of int, double, bool, std::string or StringRef.
+             */
+            template <typename T>
+            class Handle;
+
+            /* An immutable copy of the option values
+             *
+             * A snapshot is published by Config::publish() and read through Config::snapshot(),
+             * it is never modified afterwards, so any number of threads can read it without 
+             * locking while the Config object is reloaded or modified.
+             */
+            class Snapshot;
+
+#ifdef MINICONF_SHM_SUPPORT
+            /* Option values published by another process in shared memory
+             *
+             * A shared snapshot maps a segment written by Config::publishShared() read-only,
+             * and looks the values up in the binary config of the latest publication without
+             * parsing or copying them, so the processes of a host share one copy.
+             */
+            class SharedSnapshot;
+#endif
+
+            /* A per-thread cache of an option value
+             *
+             * A cached handle keeps a copy of a value read from the latest snapshot, it is
+             * refreshed only when a new snapshot has been published, so reading it costs a 
+             * relaxed atomic load and a compare. A cached handle is not shared between 
+             * threads, each thread keeps its own (e.g. as a thread_local variable).
+             */
+            template <typename T>
+            class CachedHandle;
+
+            /* Callback of a changed value
+             *
+             * It receives the flag, the previous value (empty if the value is new) and 
+             * the current value.
+             */
+            typedef std::function<void(const std::string& flag, const Value& previous, const Value& current)> ChangeCallback;
+
+#ifdef MINICONF_STATS_SUPPORT
+            /* Statistics of the last parse() call
+             *
+             * Times are wall times in seconds. The config file phases are part of the 
+             * config scan, they also accumulate when config() or reload() is called after
+             * parse(). Allocations are the heap allocations of Value objects made by the 
+             * parsing thread, small values stored inline are not counted.
+             */
+            struct ParseStats {
+                double checkFormatTime;     // format check of the options
+                double setupTime;           // indexing flags and setting default values
+                double configScanTime;      // scan of the arguments for --config, including the config files
+                double fileReadTime;        // mapping or reading config files
+                double fileLoadTime;        // loading json, csv or binary config files
+                double argumentTime;        // parsing the command line arguments
+                double validateTime;        // validation and publishing of the values
+                double totalTime;           // the whole parse() call
+                size_t allocations;         // number of Value heap allocations
+                size_t allocatedBytes;      // bytes of Value heap allocations
+                size_t options;             // number of options
+                size_t arguments;           // number of command line arguments, excluding the program name
+                size_t configFiles;         // number of config files loaded
+                size_t values;              // number of option values after parsing
+            };
+
+            // Gets the statistics of the last parse() call
+            const ParseStats& stats() const;
+#endif
+
             // Default constructor, no option is defined except the default "help" and "config"
             Config();
 
@@ -264,10 +1559,40 @@ namespace miniconf
              * @return True when parsing is successful, False when parsing error(s) occur
              */
             bool parse(int argc, char** argv);
+
+            /* Callback of a command line parsed by parseBatch()
+             *
+             * It receives the index and the result of the command line, the option values
+             * and the log messages of the command line can be read from the Config object
+             * during the call.
+             */
+            typedef std::function<void(size_t index, bool success)> BatchCallback;
+
+            /* Parses many command lines against the options of this Config
+             *
+             * Each command line is parsed as by parse(), starting from the default values,
+             * but the format check and the flag index are shared by all the command lines. 
+             * Nothing is printed and no help message is displayed, the log buffer is cleared 
+             * before each command line. The values of the last command line are published.
+             *
+             * @commandLines The arguments of each command line, the first argument should
+             * be the name of the executable
+             * @callback Called after each command line has been parsed
+             * @return The number of command lines parsed successfully
+             */
+            size_t parseBatch(const std::vector<std::vector<std::string> >& commandLines, const BatchCallback& callback = BatchCallback());
             
             // Creates a new configuration option, which is uniquely identified by its flag
             Config::Option& option(const std::string& flag);
 
+            /* Registers the options of a compile-time schema
+             *
+             * The schema should be checked by MINICONF_CHECK_SCHEMA. Existing options with
+             * the same flags are replaced.
+             */
+            template <size_t N>
+            void schema(const OptionSpec (&specs)[N]);
+
             // Removes an option
             bool remove(const std::string& flag);
 
@@ -286,6 +1611,22 @@ namespace miniconf
             // Sets the logging level, NO
             void log(const LogLevel logType);
 
+            /* Sets a sink which receives the log messages
+             *
+             * The messages are passed to the sink instead of being kept in the log buffer.
+             * An empty sink restores the log buffer.
+             */
+            void logSink(const LogSink& sink);
+
+            // Calls a function for each message in the log buffer
+            void readLog(const LogSink& reader) const;
+
+            // Gets the message text of a log code, "%s" marks the position of the detail
+            static const char* logMessage(LogCode code);
+
+            // Formats a log message as a line of text
+            static std::string formatLog(const LogRecord& record);
+
             // display the log message
             void verbose(bool value);
             
@@ -293,7 +1634,8 @@ namespace miniconf
              *
              * This function will validate the configuration format set by the user agsinst
              * invalid settings (e.g. optional arguments without a default value). This will
-             * be called during the parse() process.
+             * be called during the parse() process. The result is cached, so the check is 
+             * only performed again after the options have been modified.
              *  
              * @return The most severe level of issue detected by the process
              */
@@ -312,30 +1654,228 @@ namespace miniconf
             /* Accesses the configuration value
              *
              * If the configuration value does not exist, an empty Value object is returned. 
+             * The name of a choice assigned as a string is mapped to the choice by validate()
+             * and publish(), and is read as a string until then.
              */
             Value& operator[](const std::string& flag);
 
-            /* Load the configuration settings via a config file
-             * 
-             * This function loads a config file, if the config file has been specified in 
-             * command line arguments, this will be called automatically in "parse()" function.
+            /* Creates a typed handle of an option value
              *
-             * @configPath the input configuration file path
+             * The type is not checked at compile time: if the option is defined with a 
+             * different data type, an error is logged and the handle reads default values.
+             * An unknown flag gets a slot in the table, like operator[] does. The handle
+             * is valid for the Config object which created it, and its copies.
              */
-            void config(const std::string& configPath);
+            template <typename T>
+            Handle<T> handle(const std::string& flag);
 
-            /* Serializes the current configuration
+            /* Reads an option value through a typed handle
              *
-             * Currently JSON and CSV are supported.
+             * A default value (0, false or an empty string) is returned if the value 
+             * is not of the handle's type, or if the handle is invalid.
              */
-#ifdef MINICONF_JSON_SUPPORT
-            std::string serialize(const std::string& serializeFilePath = "", ExportFormat format = ExportFormat::JSON, bool pretty = true);
-#else
-            std::string serialize(const std::string& serializeFilePath = "", ExportFormat format = ExportFormat::CSV, bool pretty = true);
-#endif
-
-            // Enables automatically generated help message (--help/-h)
-            void enableHelp(bool enabled = true);
+            template <typename T>
+            T get(const Handle<T>& handle);
+
+            /* Gets the latest published snapshot of the option values
+             *
+             * The snapshot is loaded atomically, so it is safe to call while another thread
+             * publishes a new snapshot. The snapshot stays valid as long as it is referenced.
+             */
+            std::shared_ptr<const Snapshot> snapshot() const;
+
+            /* Publishes the current option values as a new snapshot
+             *
+             * It is called at the end of parse() and after a successful reload(), call it 
+             * explicitly after modifying values via operator[] or config(). Readers of the 
+             * previous snapshot are not blocked.
+             */
+            void publish();
+
+#ifdef MINICONF_SHM_SUPPORT
+            /* Publishes the current option values into a named shared memory segment
+             *
+             * The resolved values are written in the binary config format, other processes 
+             * read them through a SharedSnapshot. The segment holds two buffers, the values 
+             * are written into the one which is not read, then the sequence in the segment 
+             * header is bumped, so a reload is swapped atomically. The segment is replaced by
+             * a larger one if the values do not fit. Only one process may publish to a segment.
+             *
+             * @name The name of the segment, e.g. "/myapp.conf"
+             * @return True if the values have been published
+             */
+            bool publishShared(const std::string& name);
+
+            // Removes a shared memory segment, the attached snapshots keep their mapping
+            static bool unlinkShared(const std::string& name);
+#endif
+
+            /* Load the configuration settings via a config file
+             * 
+             * This function loads a config file, if the config file has been specified in 
+             * command line arguments, this will be called automatically in "parse()" function.
+             *
+             * @configPath the input configuration file path
+             */
+            void config(const std::string& configPath);
+
+            /* Loads multiple config files concurrently
+             *
+             * The files are read and parsed by a pool of threads into one staging buffer
+             * per file, then merged in the given order, so a later file takes precedence
+             * like consecutive config() calls. The log messages of each file are also 
+             * added in this order. The last path is kept for reload(). Without 
+             * MINICONF_THREAD_SUPPORT, the files are loaded on the calling thread.
+             *
+             * @configPaths The paths of the config files, from the lowest to the highest precedence
+             * @threads The maximum number of threads, 0 for the number of hardware threads. It
+             *          is not limited by the hardware threads, only by the number of files
+             * @return The number of files loaded successfully
+             */
+            size_t configFiles(const std::vector<std::string>& configPaths, size_t threads = 0);
+
+            /* Reloads the last loaded config file and notifies the changed values
+             *
+             * The file is read again on top of the current values, no default values are set 
+             * and no format check is performed. Values missing from the file keep their current
+             * value, including the ones set by command line arguments. The file is loaded into
+             * a staging buffer first, and the values are applied only if it is loaded completely,
+             * so references to the current values stay valid. Callbacks registered by onChange()
+             * are called for each value which has changed.
+             *
+             * @return True when the file is reloaded, False otherwise
+             */
+            bool reload();
+
+            /* Registers a callback for changed values during reload()
+             *
+             * @pattern A flag (e.g. "part2.subpart1.value1"), a prefix followed by "*" 
+             * (e.g. "part2.subpart1.*") or "*" for all the flags
+             * @callback The function to be called with the changed value
+             */
+            void onChange(const std::string& pattern, const ChangeCallback& callback);
+
+            /* Adds a layer of values on top of the layer stack
+             *
+             * Once a layer has been added, the option values are resolved from the layers 
+             * when they are accessed: the value of the topmost layer which defines a flag is 
+             * used, otherwise the default value of the option. A resolved value is kept until a
+             * layer or an option is modified. parse() then stores the command line arguments, 
+             * and the config files given by --config, in a layer named "arguments", which is
+             * added on top of the stack if it does not exist. Values modified via operator[] 
+             * or config() are replaced when the values are resolved again, and snapshots resolve
+             * the values from the layers, use a layer for runtime overrides instead.
+             *
+             * @return The index of the layer
+             */
+            size_t addLayer(const std::string& name);
+
+            // Finds a layer by its name, returns NO_SLOT if not found
+            size_t findLayer(const std::string& name) const;
+
+            // Gets the number of layers
+            size_t layerCount() const;
+
+            /* Loads a config file into a layer, replacing the values of the layer
+             *
+             * The previous values of the layer are kept if the file cannot be loaded completely.
+             *
+             * @return True when the file is loaded
+             */
+            bool loadLayer(size_t layer, const std::string& configPath);
+
+            // Sets a value of a layer, the name of a choice is mapped to the choice
+            void setLayerValue(size_t layer, const std::string& flag, const Value& value);
+
+            // Removes all the values of a layer
+            void clearLayer(size_t layer);
+
+            /* Loads option values from environment variables
+             *
+             * The variable of an option is the prefix followed by its flag in upper case, with 
+             * dots replaced by "__" and other characters which are not letters or digits by
+             * "_", e.g. "APP_PART2__SUBPART1__VALUE1" for the flag "part2.subpart1.value1" 
+             * with the prefix "APP_". The environment is scanned once, variables which do 
+             * not belong to an option are ignored. Elements of arrays are separated by commas.
+             * If several options map to the same variable (e.g. "a.b" and "a__b"), only the
+             * one whose flag sorts first is loaded, and a warning is logged for the others.
+             *
+             * @return The number of values loaded
+             */
+            size_t environment(const std::string& prefix);
+
+            /* Loads option values from environment variables into a layer, replacing the values of the layer
+             *
+             * @return The number of values loaded
+             */
+            size_t loadEnvironmentLayer(size_t layer, const std::string& prefix);
+
+#ifdef MINICONF_ARENA_SUPPORT
+            /* Allocates the loaded values from an arena of large blocks
+             *
+             * While config files, environment variables or arguments are loaded, the values 
+             * which do not fit into their inline buffer are allocated from blocks of blockSize
+             * bytes, which are released at once with the Config. Once the replaced values
+             * take most of the arena, e.g. after reloads, the live values are copied into a
+             * new arena and the old one is released, which invalidates views into values
+             * (e.g. StringRef and ArrayRef). A blockSize of 0 moves the values back to the
+             * heap and disables the arena.
+             */
+            void arena(size_t blockSize);
+
+            // Gets the number of bytes allocated from the arena, 0 if it is disabled
+            size_t arenaSize() const;
+#endif
+
+#ifdef MINICONF_JSON_SUPPORT
+            /* Limits the nesting depth and the size of json config files
+             *
+             * A file which is larger than maxSize bytes is rejected before it is parsed, the
+             * parsing stops at a value nested in more than maxDepth objects and arrays, and
+             * none of the values of the file are stored. Either limit is disabled by 0. By default, the depth is limited to 64 and the 
+             * size to 64 MiB.
+             */
+            void jsonLimits(size_t maxDepth, size_t maxSize);
+#endif
+
+            /* Serializes the current configuration
+             *
+             * Currently JSON, CSV and BINARY are supported.
+             */
+#ifdef MINICONF_JSON_SUPPORT
+            std::string serialize(const std::string& serializeFilePath = "", ExportFormat format = ExportFormat::JSON, bool pretty = true);
+#else
+            std::string serialize(const std::string& serializeFilePath = "", ExportFormat format = ExportFormat::CSV, bool pretty = true);
+#endif
+
+            /* Serializes the current configuration to a file stream
+             *
+             * The output is streamed while the values are visited, it is not built in memory.
+             *
+             * @return True if the output has been written completely
+             */
+            bool serialize(FILE* fd, ExportFormat format, bool pretty = true);
+
+            /* Serializes the current configuration into a buffer
+             *
+             * The output is null-terminated, and truncated if the buffer is too small.
+             *
+             * @return The length of the complete output (excluding the null character), 
+             * the output is truncated if it is not less than size
+             */
+            size_t serialize(char* buffer, size_t size, ExportFormat format, bool pretty = true);
+
+            /* Loads the configuration from serialized content, e.g. received over the network
+             *
+             * The content is parsed like a config file of the given format, BINARY content 
+             * is recognized by its header and must be 8-byte aligned like a mapped file.
+             *
+             * @return True when the values are loaded without errors
+             */
+            bool deserialize(const StringRef& content, ExportFormat format);
+
+            // Enables automatically generated help message (--help/-h)
+            void enableHelp(bool enabled = true);
 
             // Ennables setting via external config file (--config/-cfg)
             void enableConfig(bool enabled = true);
@@ -346,6 +1886,32 @@ namespace miniconf
             // Prints a automatically generated help message 
             void help(FILE* fd = stdout);
 
+            // Gets the usage message, which is rendered once until the options are modified
+            const std::string& usageText();
+
+            // Gets the help message (including the usage), which is rendered once until the options are modified
+            const std::string& helpText();
+
+            // Shells for which completion scripts are generated
+            enum class Shell {
+                BASH,
+                ZSH,
+                FISH
+            };
+
+            /* Generates a completion script of the command line flags
+             *
+             * @shell The shell of the script
+             * @command The command to be completed, the executable name by default
+             */
+            std::string completionScript(Shell shell, const std::string& command = "");
+
+            // Gets the prefix trie of the long and short flags, which is rebuilt once the options are modified
+            const FlagTrie& flagTrie();
+
+            // Completes a command line word to flags, see FlagTrie::complete()
+            std::vector<std::string> complete(const std::string& word);
+
         private:
 
             /* Types of command line arguments
@@ -365,47 +1931,295 @@ namespace miniconf
             // Sets default values to option values, used in parse() for initialization
             void setDefaultValues();
 
+            // renders the usage and help messages if the schema or the executable name has been modified
+            void renderHelp();
+
+            // Registers the options of a schema, see schema()
+            void registerSchema(const OptionSpec* specs, size_t count);
+
             // get current token type
             TokenType getTokenType(const char* token);
 
             // since long flag is the key for the option directory,
-            // this function transltes short flag to long flag
-            std::string translateShortflag(const std::string& shortflag);
+            // this function transltes short flag to the slot of its option
+            size_t translateShortflag(const char* shortflag, size_t length);
 
-            // search for options using token
-            Option* getOption(const char* token, Config::TokenType tokenType);
+            // search for the slot of an option using token, returns NO_SLOT if not found
+            size_t getOption(const char* token, Config::TokenType tokenType);
+
+            /* parses the command line arguments into the option values
+             *
+             * The default values are set and the config files are loaded before the other
+             * arguments, the values are validated afterwards. The format check and the 
+             * flag index must be up-to-date.
+             *
+             * @return The most severe level of issue detected by validation
+             */
+            LogLevel parseArguments(int argc, const char* const* argv, bool autoHelp);
 
             // determine is a flag is defined in the config
-           bool findOption(const std::string& flag);
+            bool findOption(const std::string& flag);
+
+            // search for an option by its long flag
+            Option* findFlag(const char* flag, size_t length);
+
+            // search for the slot of a short flag, returns NO_SLOT if not found
+            size_t findShortflag(const StringRef& shortflag);
+
+            // Gets the current schema version
+            size_t schemaVersion() const;
+
+            // rebuilds the short flag index if the options have been modified
+            void buildIndex();
 
             // parse a token into Value
-            Value parseValue(const char* token, Value::DataType dataType);
+            Value parseValue(const StringRef& token, Value::DataType dataType);
+
+            // parse tokens into an array Value, an unknown Value is returned if any element is invalid
+            Value parseArray(const std::vector<StringRef>& tokens, Value::DataType arrayType);
+
+            // load a config file according to its extension, returns false if it cannot be loaded
+            bool loadFile(const std::string& configPath);
+
+            // load the content of a config file according to its header or extension
+            bool loadContent(const std::string& configPath, const StringRef& configContent);
+
+            // calls the callbacks registered for a changed value
+            void notifyChange(const std::string& flag, const Value& previous, const Value& current);
+
+            // applies a reloaded value in place, and notifies it if it has changed
+            void applyReloaded(size_t slot, Value&& value);
 
 #ifdef MINICONF_JSON_SUPPORT
-            // load json config string
-            bool loadJSON(const std::string& JSONStr);
+            // load json config string, nothing is stored if the document is malformed
+            bool loadJSON(const StringRef& JSONStr);
+
+            /* A streaming (SAX-style) json parser context
+             *
+             * The JSON context receives parsing events from picojson and writes the 
+             * values into a staging buffer, no json DOM is built. The values are stored
+             * once the whole document has been parsed.
+             */
+            class JSONContext;
 
-            // parse a json value
-            bool parseJSON(const picojson::value *v, const std::string& flag); 
+            // load a value from json, the value is a NUMBER, a BOOL or a STRING
+            bool getJSONValue(Value&& v, const std::string& flag); 
+#endif
+
+            // Activates the arena while values are loaded, the outermost scope compacts the arena
+            class ArenaScope;
 
-            // load a value from json
-            bool getJSONValue(const picojson::value *v, const std::string& flag); 
+#ifdef MINICONF_ARENA_SUPPORT
+            // Copies the values into another arena, or onto the heap for nullptr, and releases the current arena
+            void moveArena(const std::shared_ptr<Arena>& arena);
+
+            // Moves the values into a new arena once the replaced values take most of the current one
+            void compactArena();
 #endif
 
             // load csv config string
-            bool loadCSV(const std::string& CSVStr);
+            bool loadCSV(const StringRef& CSVStr);
+
+            // load the environment variables of the options from a list of "NAME=VALUE" entries
+            size_t loadEnvironment(const char* const* entries, const std::string& prefix);
+
+            // maps a flag to the name of its environment variable
+            static std::string environmentName(const std::string& prefix, const StringRef& flag);
+
+            /* Header of the binary config format
+             *
+             * The header is followed by slotCount BinarySlot records and a string table of 
+             * stringsSize bytes, in which the flags and string values are stored once each.
+             * Elements of arrays are stored in the string table too, aligned to 8 bytes; a 
+             * string array is stored as (offset, length) pairs of uint32_t.
+             */
+            struct BinaryHeader {
+                char magic[8];          // "MINICONF"
+                uint32_t version;       // format version
+                uint32_t byteOrder;     // BINARY_BYTE_ORDER in the writer's byte order
+                uint64_t schemaHash;    // hash of the option flags and types of the writer
+                uint32_t slotCount;     // number of values
+                uint32_t stringsSize;   // size of the string table in bytes
+            };
+
+            // A value of the binary config format
+            struct BinarySlot {
+                uint32_t key;           // offset of the flag in the string table
+                uint32_t keyLength;     // length of the flag
+                uint32_t type;          // Value::DataType of the value
+                uint32_t length;        // length of a string value, or number of array elements
+                uint64_t payload;       // INT, NUMBER (bits) or BOOL value, or the string / array offset
+            };
+
+            // Current version of the binary config format
+            static const uint32_t BINARY_VERSION = 1;
+
+            // Marker to detect files written with a different byte order
+            static const uint32_t BINARY_BYTE_ORDER = 0x01020304;
+
+            // Checks if a config file is in the binary format
+            static bool isBinary(const StringRef& content);
+
+            // load binary config, the values are read from the buffer without parsing
+            bool loadBinary(const StringRef& content);
+
+            // checks if the elements of an array in a binary config are in bounds and aligned, true for other types
+            static bool checkBinaryArray(const char* strings, const BinaryHeader& header, const BinarySlot& record);
 
-            // internal function for adding log messages
-            void log(LogLevel logType, const std::string& token, const std::string& msg);
+            // serializes the values to the binary config format
+            void writeBinary(Writer& out);
 
-            // this map stores configuration format design, e.g. flag, default values.
-            std::map<std::string, Option> _options;
+#ifdef MINICONF_SHM_SUPPORT
+            /* Header of a shared memory segment
+             *
+             * The header is followed by two buffers of capacity bytes, publication n is a 
+             * binary config in buffer n % 2. The sequence is 2n once publication n is complete
+             * and 2n + 1 while publication n + 1 is written (a seqlock), so the buffer of the 
+             * latest publication is only overwritten by the second publication after it. The
+             * atomics are shared by the processes mapping the segment, so they must be lock-free.
+             */
+            struct SharedHeader {
+                char magic[8];                      // "MINISHM"
+                std::atomic<uint64_t> sequence;     // 0 until the first publication is complete
+                std::atomic<uint32_t> retired;      // set when the segment is replaced by a larger one
+                uint32_t reserved;
+                uint64_t capacity;                  // size of each buffer, a multiple of 8
+                uint64_t sizes[2];                  // size of the binary config in each buffer
+
+                // an atomic with a lock would only synchronize the threads of one process
+                static_assert(ATOMIC_INT_LOCK_FREE == 2 && ATOMIC_LONG_LOCK_FREE == 2 && ATOMIC_LLONG_LOCK_FREE == 2,
+                        "MINICONF_SHM_SUPPORT requires lock-free 32-bit and 64-bit atomics");
+                static_assert(sizeof(std::atomic<uint64_t>) == sizeof(uint64_t) && sizeof(std::atomic<uint32_t>) == sizeof(uint32_t),
+                        "the layout of a shared memory segment requires atomics of the size of their values");
+            };
+
+            // Minimum size of the buffers of a new shared memory segment
+            static const uint64_t SHARED_MIN_CAPACITY = 4096;
+
+            // creates a shared memory segment with a first publication, and replaces the segment of the same name
+            bool createShared(const std::string& name, const std::string& content, uint64_t publication);
+#endif
+
+            // serializes the values in a given format
+            void serializeTo(Writer& out, ExportFormat format, bool pretty);
+
+#ifdef MINICONF_JSON_SUPPORT
+            /* serializes the values to json
+             *
+             * The values are visited in the order of their flags, nested objects are opened 
+             * and closed by comparing the dotted flag with the flag of the previous value.
+             */
+            void writeJSON(Writer& out, bool pretty);
+
+            // writes an escaped json string
+            static void writeJSONString(Writer& out, const StringRef& str);
+
+            // writes a value as a json scalar or array, indented at a level (-1 is compact)
+            static void writeJSONValue(Writer& out, const Value& value, int indent);
+
+            // writes a json number
+            static void writeJSONNumber(Writer& out, double number);
+#endif
+
+            // serializes the values to csv
+            void writeCSV(Writer& out);
+
+            // hash of the flags and data types of the options, identifies the schema of binary configs
+            uint64_t schemaHash();
+
+            /* read a csv field from a buffer and advance the position past its delimiter
+             *
+             * An unquoted field refers to the input buffer, a quoted field is unescaped into
+             * the given buffer. endOfRecord is set when the field ends a line.
+             */
+            static StringRef readCSVField(const char*& pos, const char* end, std::string& buffer, bool& endOfRecord);
+
+            // writes a csv field, quoted if it contains commas, quotes or line breaks
+            static void writeCSVField(Writer& out, const StringRef& field);
+
+            // gets the value of a flag, an empty value is created if necessary
+            Value& valueOf(const StringRef& flag);
+
+            // gets the value of a slot, in the layer being loaded if any, an empty value is created if necessary
+            Value& valueAt(size_t slot);
+
+            // resolves the value of a slot from the layers, unless it is resolved since the layers were modified
+            void resolve(size_t slot);
+
+            // gets the value of the topmost layer which defines a slot, or nullptr
+            const Value* layerValue(size_t slot);
+
+            // maps the name of a choice which is stored as a STRING (e.g. by operator[]) to a CHOICE value
+            void mapChoice(size_t slot, Value& value) const;
+
+            // resolves the values of all the slots, e.g. before all the values are visited
+            void resolveAll();
+
+            // marks the resolved values as outdated after a layer is modified
+            void invalidate();
+
+            // internal function for adding log messages, messages below the log level are ignored at the call site
+            void log(LogLevel logType, LogCode code, const StringRef& token, const StringRef& detail = StringRef())
+            {
+                if (logType >= _logLevel) {
+                    record(logType, code, token, detail);
+                }
+            }
+
+            // passes a log message to the sink, or appends it to the log buffer
+            void record(LogLevel logType, LogCode code, const StringRef& token, const StringRef& detail);
 
-            // this map stores the values parsed form user input
-            std::map<std::string, Value> _optionValues;
+            /* A message in the log buffer
+             *
+             * The token and the detail are stored in a shared text buffer, so adding
+             * a message does not allocate once the buffers have grown.
+             */
+            struct LogEntry {
+                LogLevel level;
+                LogCode code;
+                size_t token;               // offset of the token in the text buffer
+                size_t tokenLength;
+                size_t detail;              // offset of the detail in the text buffer
+                size_t detailLength;
+            };
+
+            /* The values and log messages of a config file loaded by configFiles()
+             *
+             * While a thread loads a file into a staging buffer, the values and the log
+             * messages are redirected to the buffer and the table is only read.
+             */
+            struct Staging {
+                std::vector<std::pair<size_t, Value> > values;          // values of flags with a slot
+                std::vector<std::pair<std::string, Value> > strays;     // values of flags without a slot
+                std::vector<LogEntry> log;
+                std::string logText;
+                bool loaded;
+            };
+
+            // Gets the staging buffer of the current thread, or nullptr
+            static Staging*& staging();
+
+            // loads a config file into a staging buffer, called by the threads of configFiles()
+            void stageFile(const std::string& configPath, Staging& stage);
+
+            // stores the values of a staging buffer, and adds its log messages to the log
+            void commitStage(Staging& stage);
+
+            // adds the log messages of a staging buffer to the log
+            void replayLog(const Staging& stage);
+
+            // this table stores configuration format design (e.g. flag, default values) and
+            // the values parsed form user input, in the same slot for each flag
+            FlatTable<Option> _table;
 
             // this is a stack of log messages
-            std::vector<std::string> _log;
+            std::vector<LogEntry> _log;
+
+            // tokens and details of the log messages
+            std::string _logText;
+
+            // receives the log messages instead of the log buffer if set
+            LogSink _logSink;
 
             // switch for verbose
             bool _verbose;  
@@ -415,6 +2229,21 @@ namespace miniconf
             
             // program name stripped from command line
             std::string _exeName; 
+
+            // the rendered usage message
+            std::string _usageText;
+
+            // the rendered help message
+            std::string _helpText;
+
+            // the schema version at which the messages have been rendered, 0 if they are outdated
+            size_t _helpVersion;
+
+            // the prefix trie of the command line flags
+            FlagTrie _flagTrie;
+
+            // the schema version at which the trie has been built
+            size_t _trieVersion;
             
             // the program's description
             std::string _description; 
@@ -425,6 +2254,72 @@ namespace miniconf
             // switch for enable loading configuration
             bool _loadConfig; 
 
+            // hash index of short flags to slots
+            FlagIndex _shortflagIndex;
+
+            // schema version of the short flag index
+            size_t _indexVersion;
+
+            /* incremented whenever an option or the description is modified
+             *
+             * The options point to the counter, so it stays in place when the Config is
+             * copied and is shared by the copies, which only causes spurious rebuilds.
+             */
+            std::shared_ptr<std::atomic<size_t> > _schemaVersion;
+
+            // schema version of the last format check
+            size_t _checkedVersion;
+
+            // result of the last format check
+            LogLevel _checkFormatResult;
+
+            // path of the last loaded config file
+            std::string _configPath;
+
+            // change callbacks and their flag patterns
+            std::vector<std::pair<std::string, ChangeCallback> > _changeCallbacks;
+
+            // the latest published snapshot, accessed with std::atomic_load / std::atomic_store
+            std::shared_ptr<const Snapshot> _snapshot;
+
+            // version of the latest published snapshot, the generation read by cached handles
+            AtomicCounter _snapshotVersion;
+
+            // the layer stack, from the lowest to the topmost layer
+            std::vector<ValueLayer> _layers;
+
+            // index of the layer receiving loaded values, or NO_SLOT
+            size_t _loadingLayer;
+
+            // incremented whenever a layer is modified
+            size_t _layerVersion;
+
+            // the layer and schema versions at which each slot has been resolved
+            std::vector<size_t> _resolvedVersion;
+
+#ifdef MINICONF_ARENA_SUPPORT
+            // the arena of the loaded values or nullptr, shared so a Config remains copyable
+            std::shared_ptr<Arena> _arena;
+
+            // size of the arena blocks, 0 if the arena is disabled
+            size_t _arenaBlockSize;
+
+            // bytes of the arena which were allocated when it was last compacted
+            size_t _arenaLive;
+
+            // number of nested ArenaScope objects
+            size_t _arenaDepth;
+#endif
+
+            // the limits of the nesting depth and of the size of json config files, 0 if unlimited
+            size_t _jsonMaxDepth;
+            size_t _jsonMaxSize;
+
+#ifdef MINICONF_STATS_SUPPORT
+            // statistics of the last parse() call
+            ParseStats _stats;
+#endif
+
     };
 
     /*
@@ -477,6 +2372,27 @@ namespace miniconf
             // Sets the default value of an option from a string
             Config::Option& defaultValue(const std::string& defaultValue);
 
+            // Sets the default value of an array option of integers
+            Config::Option& defaultValue(const std::vector<int>& defaultValue);
+
+            // Sets the default value of an array option of floating point numbers
+            Config::Option& defaultValue(const std::vector<double>& defaultValue);
+
+            // Sets the default value of an array option of booleans
+            Config::Option& defaultValue(const std::vector<bool>& defaultValue);
+
+            // Sets the default value of an array option of strings
+            Config::Option& defaultValue(const std::vector<std::string>& defaultValue);
+
+            /* Restricts the values of an option to a list of choices
+             *
+             * The values are stored as CHOICE values, a name is mapped to the index of 
+             * the choice once when it is parsed. The default value is given by its name, 
+             * before or after the choices. Names which are not choices are reported by 
+             * Config::validate().
+             */
+            Config::Option& choices(const std::vector<std::string>& choices);
+
             // Makes an option to be required or optional
             Config::Option& required(const bool required);
 
@@ -486,29 +2402,40 @@ namespace miniconf
              */
             Config::Option& hidden(const bool hidden);
 
-            // Prints the flag of an option as a string
-            std::string flag();
+            // Gets the flag of an option
+            const std::string& flag() const;
+
+            // Gets the shortflag of an option
+            const std::string& shortflag() const;
 
-            // Prints the shortflag of an option as a string
-            std::string shortflag();
+            // Gets the description of an option
+            const std::string& description() const;
 
-            // Prints the description of an option
-            std::string description();
+            // Gets the choices of an option, empty if the option is not a choice
+            const std::vector<std::string>& choices() const;
+
+            // Maps a name to a CHOICE value, the index is -1 if the name is not a choice
+            Value choice(const StringRef& name) const;
 
             // Returns the default value of an option
-            Value defaultValue();
+            const Value& defaultValue() const;
 
             // Checks if the option is required or optional
-            bool required();
+            bool required() const;
 
             // Gets the data type 
-            Value::DataType type();
+            Value::DataType type() const;
 
             // Checks if an option is hidden
-            bool hidden();
+            bool hidden() const;
 
         private:
 
+            friend class Config;
+
+            // Increments the schema version of the owning Config, if any
+            void modified();
+
             // Flag of the option
             std::string     _flag;          
             
@@ -520,6 +2447,9 @@ namespace miniconf
             
             // Default value of the option
             Value           _defaultValue;
+
+            // Names of the choices, in the order of their indices
+            std::vector<std::string> _choices;
             
             // Option is required to be specified
             bool            _required;
@@ -527,1019 +2457,5227 @@ namespace miniconf
             // Option is hidden
             bool            _hidden;
 
-    };
-
-    /*********************************************************************/
-    /*********************************************************************/
-    /*********************** IMPLEMENTATION BELOW ************************/
-    /*********************************************************************/
-    /*********************************************************************/
+            // Schema version of the owning Config, bumped by the setters so cached messages notice them
+            std::atomic<size_t>* _schemaVersion;
 
-    // Value
-    Value::Value() : _type(DataType::UNKNOWN), _size(0), _data(nullptr)
-    {}
+    };
 
-    Value::Value(const Value& other) : Value()
+    template <typename T>
+    class Config::Handle
     {
-        copyData(other._data, other._size, other._type);
-    }
+        public:
 
-    Value::Value(Value&& other) : Value()
-    {
-        moveData(other._data, other._size, other._type);
-    }
+            // Creates an invalid handle
+            Handle();
 
+            // Checks if the handle has been created by Config::handle()
+            bool valid() const;
 
-    Value& Value::operator=(const Value& other)
-    {
-        clearData();
-        return copyData(other._data, other._size, other._type);
-    }
+        private:
 
-    Value& Value::operator=(Value&& other)
-    {
-        return moveData(other._data, other._size, other._type);
-    }
+            friend class Config;
 
-    Value::~Value()
-    {
-        clearData();
-    }
+            // Creates a handle of a slot
+            explicit Handle(size_t slot);
 
-    //  int
-    Value::Value(const int& other) : Value()
-    {
-        copyData(reinterpret_cast<const char*>(&other), sizeof(int), DataType::INT);
-    }
+            // Slot of the flag in the Config object
+            size_t _slot;
+    };
 
-    Value& Value::operator=(const int& other)
+    template <typename T>
+    class Config::CachedHandle
     {
-        clearData();
-        return copyData(reinterpret_cast<const char*>(&other), sizeof(int), DataType::INT);
-    }
+        public:
+
+            /* Creates a cached handle of a value
+             *
+             * @config The Config object which publishes the snapshots, it must outlive the handle
+             * @handle A handle created by config.handle<T>(), before the threads are started
+             */
+            CachedHandle(const Config& config, const Handle<T>& handle);
+
+            // Gets the cached value, it is refreshed if a new snapshot has been published
+            const T& get();
+
+            // Gets the cached value
+            operator const T&();
+
+        private:
+
+            // Reads the value from the latest snapshot
+            void refresh();
+
+            // The Config object which publishes the snapshots
+            const Config* _config;
+
+            // Handle of the value
+            Handle<T> _handle;
+
+            // Snapshot version of the cached value
+            size_t _version;
+
+            // The snapshot of the cached value, it keeps referred strings alive
+            std::shared_ptr<const Snapshot> _snapshot;
+
+            // The cached value
+            T _value;
+    };
+
+    class Config::Snapshot
+    {
+        public:
+
+            /* Accesses a value in the snapshot
+             *
+             * If the value does not exist, an empty Value object is returned. 
+             */
+            const Value& operator[](const std::string& flag) const;
+
+            // Checks if the option value is defined in the snapshot
+            bool contains(const std::string& flag) const;
+
+            /* Reads a value through a typed handle created by the Config object
+             *
+             * A default value is returned if the value is not of the handle's type, or if
+             * the handle has been created after the snapshot.
+             */
+            template <typename T>
+            T get(const Handle<T>& handle) const;
+
+            // Gets the version of the snapshot, which increases with each publish()
+            size_t version() const;
+
+        private:
+
+            friend class Config;
+
+            // Copies the option values of a Config object, and shares its sorted layers
+            Snapshot(const FlatTable<Option>& table, const std::vector<std::shared_ptr<const ValueLayer::Values> >& layers, size_t version);
+
+            // Gets the slot of a flag, or NO_SLOT
+            size_t slotOf(const std::string& flag) const;
+
+            // Gets the value of a slot, or an empty value
+            const Value& valueAt(size_t slot) const;
+
+            // The copied options and values, slots are the same as in the Config object
+            FlatTable<Option> _table;
+
+            // The values of the layers from the lowest to the topmost, resolved when they are read
+            std::vector<std::shared_ptr<const ValueLayer::Values> > _layers;
+
+            // Version of the snapshot
+            size_t _version;
+
+            // An empty value returned for undefined flags
+            Value _empty;
+    };
+
+#ifdef MINICONF_SHM_SUPPORT
+    class Config::SharedSnapshot
+    {
+        public:
+
+            // Attaches to a shared memory segment, good() is false until a publication is read
+            explicit SharedSnapshot(const std::string& name);
+
+            // Unmaps the segment
+            ~SharedSnapshot();
+
+            // Checks if a publication is attached
+            bool good() const;
+
+            /* Attaches to the latest publication
+             *
+             * The segment is mapped again if the publisher has replaced it. The attached 
+             * publication is kept if no newer one can be read.
+             *
+             * @return True if a newer publication has been attached
+             */
+            bool refresh();
+
+            /* Checks that the attached publication has not been overwritten
+             *
+             * The values are not copied, the references returned by the getters point into
+             * the shared memory. A publication is overwritten by the second publication after
+             * it: check valid() after reading the values, and refresh() and read them again 
+             * if it returns false. The references are released by a successful refresh().
+             */
+            bool valid() const;
+
+            // Gets the version of the attached publication, which increases with each publishShared()
+            uint64_t version() const;
+
+            // Checks if a value is published
+            bool contains(const StringRef& flag) const;
+
+            // Gets the type of a published value, UNKNOWN if it is not published
+            Value::DataType type(const StringRef& flag) const;
+
+            /* Reads a published value
+             *
+             * The fallback (or an empty array) is returned if the value is not published, or 
+             * if it is of another type. A choice is published by its name, read by getString().
+             */
+            int getInt(const StringRef& flag, int fallback = 0) const;
+            double getNumber(const StringRef& flag, double fallback = 0.0) const;
+            bool getBoolean(const StringRef& flag, bool fallback = false) const;
+            StringRef getString(const StringRef& flag, const StringRef& fallback = StringRef()) const;
+            ArrayRef<int> getIntArray(const StringRef& flag) const;
+            ArrayRef<double> getNumberArray(const StringRef& flag) const;
+            ArrayRef<bool> getBooleanArray(const StringRef& flag) const;
+            std::vector<StringRef> getStringArray(const StringRef& flag) const;
+
+            /* Copies the values of the attached publication into a Config object
+             *
+             * @return False if no publication is attached, or if it is overwritten while copied
+             */
+            bool load(Config& config) const;
+
+        private:
+
+            // A SharedSnapshot owns its mapping and cannot be copied
+            SharedSnapshot(const SharedSnapshot& other);
+            SharedSnapshot& operator=(const SharedSnapshot& other);
+
+            // Maps a segment read-only, nullptr if it does not exist or is not initialized yet
+            static const SharedHeader* map(const std::string& name, size_t& mappedSize);
+
+            // Attaches to the latest publication in a segment if it is newer than the attached one
+            bool read(const SharedHeader* header);
+
+            // Checks that the records of a binary config are in bounds and sorted by flag
+            static bool check(const StringRef& content);
+
+            // Finds the record of a flag by binary search, nullptr if it is not published
+            const BinarySlot* find(const StringRef& flag) const;
+
+            // Name of the segment
+            std::string _name;
+
+            // The mapped segment
+            const SharedHeader* _header;
+
+            // Size of the mapping
+            size_t _mappedSize;
+
+            // Sequence of the attached publication, 0 if none
+            uint64_t _sequence;
+
+            // Binary config of the attached publication
+            StringRef _content;
+
+            // Records of the attached publication, they are aligned in the mapped buffer
+            const BinarySlot* _slots;
+
+            // Number of records
+            size_t _slotCount;
+
+            // String table of the attached publication
+            const char* _strings;
+    };
+#endif
+
+#ifdef MINICONF_JSON_SUPPORT
+    class Config::JSONContext
+    {
+        public:
+
+            // Creates a context which loads values into a Config object
+            explicit JSONContext(Config& config);
+
+            // Checks if all the values have been loaded successfully
+            bool success() const;
+
+            // Checks if the parsing has been stopped by the depth limit
+            bool tooDeep() const;
+
+            // picojson callbacks
+            bool set_null();
+            bool set_bool(bool b);
+            bool set_number(double f);
+#ifdef PICOJSON_USE_INT64
+            bool set_int64(int64_t i);
+#endif
+            template <typename Iter> bool parse_string(picojson::input<Iter>& in);
+            bool parse_array_start();
+            template <typename Iter> bool parse_array_item(picojson::input<Iter>& in, size_t idx);
+            bool parse_array_stop(size_t size);
+            bool parse_object_start();
+            template <typename Iter> bool parse_object_item(picojson::input<Iter>& in, const std::string& key);
+
+        private:
+
+            // Skips a nested value which is not stored, within the same depth limit
+            class SkipContext;
+
+            // Parses a value, numbers are parsed by NumberParser and others by picojson
+            template <typename Iter> bool parseValue(picojson::input<Iter>& in);
+
+            // Enters an object or array item, fails if the item exceeds the depth limit
+            bool enter();
+
+            // Leaves an object or array item
+            void leave();
+
+            // Checks the type of an array element, all the elements must be of the same type
+            bool addElement(Value::DataType type);
+
+            // The config object which receives the values
+            Config& _config;
+
+            // Dotted flag of the current value, e.g. "part2.subpart1.value1"
+            std::string _flag;
+
+            // Reusable buffer for string values and number literals
+            std::string _string;
+
+            // Checks if all the values have been loaded successfully
+            bool _success;
+
+            // Checks if the elements of an array are being parsed
+            bool _inArray;
+
+            // Checks if the current array contains only supported elements of the same type
+            bool _arrayValid;
+
+            // Element type of the current array, UNKNOWN if it is empty
+            Value::DataType _elementType;
+
+            // Elements of the current array, reused for all arrays
+            std::vector<double> _numbers;
+            std::vector<bool> _booleans;
+            std::vector<std::string> _strings;
+
+            // Number of objects and arrays the current value is nested in
+            size_t _depth;
+
+            // Checks if the depth limit has been exceeded
+            bool _tooDeep;
+    };
+
+    class Config::JSONContext::SkipContext : public picojson::null_parse_context
+    {
+        public:
+
+            // Creates a context which counts the depth of the skipped items in the parent context
+            explicit SkipContext(JSONContext& parent);
+
+            // picojson callbacks of nested items, others are inherited from null_parse_context
+            template <typename Iter> bool parse_array_item(picojson::input<Iter>& in, size_t idx);
+            template <typename Iter> bool parse_object_item(picojson::input<Iter>& in, const std::string& key);
+
+        private:
+
+            // The context of the enclosing value
+            JSONContext& _parent;
+    };
+#endif
+
+    // Activates the arena of a Config on the current thread for the lifetime of the scope,
+    // it does nothing without MINICONF_ARENA_SUPPORT
+    class Config::ArenaScope
+    {
+        public:
+
+            // Activates the arena, an arena shared with a copied Config is replaced first
+            explicit ArenaScope(Config& config);
+
+            // Restores the previous arena, the outermost scope compacts the arena
+            ~ArenaScope();
+
+#ifdef MINICONF_ARENA_SUPPORT
+        private:
+
+            // The Config owning the arena
+            Config& _config;
+
+            // The arena which was active before the scope
+            Arena* _previous;
+#endif
+    };
+
+    /*********************************************************************/
+    /*********************************************************************/
+    /*********************** IMPLEMENTATION BELOW ************************/
+    /*********************************************************************/
+    /*********************************************************************/
+
+    // StringRef
+    StringRef::StringRef() : _data(""), _size(0)
+    {}
+
+    StringRef::StringRef(const char* str) : _data(str), _size(strlen(str))
+    {}
+
+    StringRef::StringRef(const char* str, size_t length) : _data(str), _size(length)
+    {}
+
+    StringRef::StringRef(const std::string& str) : _data(str.c_str()), _size(str.size())
+    {}
+
+    const char* StringRef::data() const
+    {
+        return _data;
+    }
+
+    size_t StringRef::size() const
+    {
+        return _size;
+    }
+
+    bool StringRef::empty() const
+    {
+        return _size == 0;
+    }
+
+    std::string StringRef::str() const
+    {
+        return std::string(_data, _size);
+    }
+
+    bool StringRef::operator==(const StringRef& other) const
+    {
+        return _size == other._size && memcmp(_data, other._data, _size) == 0;
+    }
+
+    bool StringRef::operator!=(const StringRef& other) const
+    {
+        return !(*this == other);
+    }
+
+    // ArrayRef
+    template <typename T>
+    ArrayRef<T>::ArrayRef() : _data(nullptr), _size(0)
+    {}
+
+    template <typename T>
+    ArrayRef<T>::ArrayRef(const T* data, size_t size) : _data(data), _size(size)
+    {}
+
+    template <typename T>
+    const T* ArrayRef<T>::data() const
+    {
+        return _data;
+    }
+
+    template <typename T>
+    size_t ArrayRef<T>::size() const
+    {
+        return _size;
+    }
+
+    template <typename T>
+    bool ArrayRef<T>::empty() const
+    {
+        return _size == 0;
+    }
+
+    template <typename T>
+    const T& ArrayRef<T>::operator[](size_t i) const
+    {
+        return _data[i];
+    }
+
+    template <typename T>
+    const T* ArrayRef<T>::begin() const
+    {
+        return _data;
+    }
+
+    template <typename T>
+    const T* ArrayRef<T>::end() const
+    {
+        return _data + _size;
+    }
+
+    template <typename T>
+    std::vector<T> ArrayRef<T>::vec() const
+    {
+        return std::vector<T>(begin(), end());
+    }
+
+    ArrayRef<StringRef>::ArrayRef() : _buffer(nullptr), _size(0)
+    {}
+
+    ArrayRef<StringRef>::ArrayRef(const char* buffer) : _buffer(buffer), _size(0)
+    {
+        uint32_t count;
+        memcpy(&count, buffer, sizeof(uint32_t));
+        _size = count;
+    }
+
+    size_t ArrayRef<StringRef>::size() const
+    {
+        return _size;
+    }
+
+    bool ArrayRef<StringRef>::empty() const
+    {
+        return _size == 0;
+    }
+
+    StringRef ArrayRef<StringRef>::operator[](size_t i) const
+    {
+        uint32_t offsets[2];
+        memcpy(offsets, _buffer + sizeof(uint32_t) * (i + 1), sizeof(offsets));
+        const char* chars = _buffer + sizeof(uint32_t) * (_size + 2);
+        // each element is followed by a null character
+        return StringRef(chars + offsets[0], offsets[1] - offsets[0] - 1);
+    }
+
+    ArrayRef<StringRef>::const_iterator ArrayRef<StringRef>::begin() const
+    {
+        return const_iterator(this, 0);
+    }
+
+    ArrayRef<StringRef>::const_iterator ArrayRef<StringRef>::end() const
+    {
+        return const_iterator(this, _size);
+    }
+
+    std::vector<std::string> ArrayRef<StringRef>::vec() const
+    {
+        std::vector<std::string> out;
+        out.reserve(_size);
+        for (size_t i = 0; i < _size; ++i) {
+            out.push_back((*this)[i].str());
+        }
+        return out;
+    }
+
+    // FileBuffer
+    FileBuffer::FileBuffer(const std::string& path) : _data(""), _size(0), _good(false), _mapped(false), _buffer()
+    {
+#ifdef MINICONF_MMAP_SUPPORT
+        int fd = open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            return;
+        }
+        struct stat st;
+        if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode)) {
+            _good = true;
+            _size = static_cast<size_t>(st.st_size);
+            if (_size > 0) {
+                void* mapped = mmap(nullptr, _size, PROT_READ, MAP_PRIVATE, fd, 0);
+                if (mapped != MAP_FAILED) {
+                    madvise(mapped, _size, MADV_SEQUENTIAL);
+                    _data = static_cast<const char*>(mapped);
+                    _mapped = true;
+                } else {
+                    // fall back to a single read
+                    _buffer.resize(_size);
+                    ssize_t n = pread(fd, _buffer.data(), _size, 0);
+                    _good = (n == static_cast<ssize_t>(_size));
+                    _size = _good ? _size : 0;
+                    _data = _good ? _buffer.data() : "";
+                }
+            }
+        }
+        close(fd);
+#else
+        FILE* fd = fopen(path.c_str(), "rb");
+        if (!fd) {
+            return;
+        }
+        if (fseek(fd, 0, SEEK_END) == 0) {
+            long size = ftell(fd);
+            if (size >= 0 && fseek(fd, 0, SEEK_SET) == 0) {
+                _buffer.resize(static_cast<size_t>(size));
+                _size = fread(_buffer.data(), 1, _buffer.size(), fd);
+                _good = (_size == _buffer.size());
+                _data = _buffer.data();
+            }
+        }
+        fclose(fd);
+#endif
+    }
+
+    FileBuffer::~FileBuffer()
+    {
+#ifdef MINICONF_MMAP_SUPPORT
+        if (_mapped) {
+            munmap(const_cast<char*>(_data), _size);
+        }
+#endif
+    }
+
+    bool FileBuffer::good() const
+    {
+        return _good;
+    }
+
+    StringRef FileBuffer::content() const
+    {
+        return StringRef(_data, _size);
+    }
+
+    // FileWatcher
+    FileWatcher::FileWatcher(const std::string& path) : _fd(-1), _name()
+    {
+#ifdef MINICONF_INOTIFY_SUPPORT
+        // watch the directory, editors often replace the file instead of writing to it
+        size_t lastslash = path.find_last_of("/");
+        std::string directory = (lastslash == std::string::npos) ? "." : path.substr(0, lastslash + 1);
+        _name = (lastslash == std::string::npos) ? path : path.substr(lastslash + 1);
+        _fd = inotify_init1(IN_CLOEXEC);
+        if (_fd >= 0 && inotify_add_watch(_fd, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE) < 0) {
+            close(_fd);
+            _fd = -1;
+        }
+#else
+        (void)path;
+#endif
+    }
+
+    FileWatcher::~FileWatcher()
+    {
+#ifdef MINICONF_INOTIFY_SUPPORT
+        if (_fd >= 0) {
+            close(_fd);
+        }
+#endif
+    }
+
+    bool FileWatcher::good() const
+    {
+        return _fd >= 0;
+    }
+
+    int FileWatcher::fd() const
+    {
+        return _fd;
+    }
+
+    bool FileWatcher::wait(int timeout)
+    {
+#ifdef MINICONF_INOTIFY_SUPPORT
+        if (_fd < 0) return false;
+        alignas(struct inotify_event) char buffer[4096];
+        while (true) {
+            struct pollfd pfd = { _fd, POLLIN, 0 };
+            int ready = poll(&pfd, 1, timeout);
+            if (ready <= 0) return false;
+            ssize_t length = read(_fd, buffer, sizeof(buffer));
+            if (length <= 0) return false;
+            // events of other files in the same directory are skipped
+            for (ssize_t offset = 0; offset < length; ) {
+                const struct inotify_event* event = reinterpret_cast<const struct inotify_event*>(buffer + offset);
+                if (event->len > 0 && _name == event->name) {
+                    return true;
+                }
+                offset += static_cast<ssize_t>(sizeof(struct inotify_event) + event->len);
+            }
+        }
+#else
+        (void)timeout;
+        return false;
+#endif
+    }
+
+    // Writer
+    Writer::Writer(FILE* fd) : _fd(fd), _string(nullptr), _buffer(nullptr), _capacity(0), _size(0), _good(fd != nullptr)
+    {}
+
+    Writer::Writer(std::string& out) : _fd(nullptr), _string(&out), _buffer(nullptr), _capacity(0), _size(0), _good(true)
+    {}
+
+    Writer::Writer(char* buffer, size_t size) : _fd(nullptr), _string(nullptr), _buffer(buffer), _capacity(size), _size(0), _good(buffer != nullptr && size > 0)
+    {}
+
+    void Writer::write(const char* data, size_t size)
+    {
+        if (_string) {
+            _string->append(data, size);
+        } else if (_fd) {
+            _good = (fwrite(data, 1, size, _fd) == size) && _good;
+        } else if (_buffer) {
+            // keep one character for the null terminator
+            size_t available = (_size + 1 < _capacity) ? _capacity - 1 - _size : 0;
+            size_t n = (size < available) ? size : available;
+            memcpy(_buffer + _size, data, n);
+            _good = (n == size) && _good;
+        }
+        _size += size;
+    }
+
+    void Writer::write(const StringRef& str)
+    {
+        write(str.data(), str.size());
+    }
+
+    void Writer::put(char c)
+    {
+        if (_string) {
+            _string->push_back(c);
+            ++_size;
+        } else {
+            write(&c, 1);
+        }
+    }
+
+    void Writer::terminate()
+    {
+        if (_buffer && _capacity > 0) {
+            _buffer[(_size < _capacity) ? _size : _capacity - 1] = '\0';
+        }
+    }
+
+    size_t Writer::size() const
+    {
+        return _size;
+    }
+
+    bool Writer::good() const
+    {
+        return _good;
+    }
+
+    // NumberParser
+    bool NumberParser::parseInt(const StringRef& token, int& value)
+    {
+        const char* p = token.data();
+        const char* end = p + token.size();
+        trim(p, end);
+        bool negative = false;
+        if (p != end && (*p == '+' || *p == '-')) {
+            negative = (*p == '-');
+            ++p;
+        }
+        if (p == end) return false;
+        // accumulate in a wider type, one more than INT_MAX is allowed for INT_MIN
+        const int64_t limit = static_cast<int64_t>(std::numeric_limits<int>::max()) + (negative ? 1 : 0);
+        int64_t v = 0;
+        for (; p != end; ++p) {
+            if (*p < '0' || *p > '9') return false;
+            v = v * 10 + (*p - '0');
+            if (v > limit) return false;
+        }
+        value = static_cast<int>(negative ? -v : v);
+        return true;
+    }
+
+    bool NumberParser::parseNumber(const StringRef& token, double& value)
+    {
+        // exactly representable powers of ten
+        static const double powers[] = {
+            1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+            1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+        };
+        const char* first = token.data();
+        const char* end = first + token.size();
+        trim(first, end);
+        const char* p = first;
+        bool negative = false;
+        if (p != end && (*p == '+' || *p == '-')) {
+            negative = (*p == '-');
+            ++p;
+        }
+
+        // infinity and NaN, case insensitive
+        if (p != end && (*p == 'i' || *p == 'I' || *p == 'n' || *p == 'N')) {
+            if (matchWord(p, end, "inf") || matchWord(p, end, "infinity")) {
+                value = negative ? -std::numeric_limits<double>::infinity() : std::numeric_limits<double>::infinity();
+                return true;
+            }
+            if (matchWord(p, end, "nan")) {
+                value = std::numeric_limits<double>::quiet_NaN();
+                return true;
+            }
+            return false;
+        }
+
+        // significand, at most 19 significant digits fit in 64 bits
+        uint64_t mantissa = 0;
+        int digits = 0;
+        int exponent = 0;
+        bool anyDigit = false;
+        bool truncated = false;
+        for (; p != end && *p >= '0' && *p <= '9'; ++p) {
+            anyDigit = true;
+            if (digits < 19) {
+                mantissa = mantissa * 10 + static_cast<uint64_t>(*p - '0');
+                if (mantissa != 0) ++digits;
+            } else {
+                ++exponent;
+                truncated = truncated || (*p != '0');
+            }
+        }
+        if (p != end && *p == '.') {
+            ++p;
+            for (; p != end && *p >= '0' && *p <= '9'; ++p) {
+                anyDigit = true;
+                if (digits < 19) {
+                    mantissa = mantissa * 10 + static_cast<uint64_t>(*p - '0');
+                    if (mantissa != 0) ++digits;
+                    --exponent;
+                } else {
+                    truncated = truncated || (*p != '0');
+                }
+            }
+        }
+        if (!anyDigit) return false;
+
+        // exponent part
+        if (p != end && (*p == 'e' || *p == 'E')) {
+            ++p;
+            bool negativeExp = false;
+            if (p != end && (*p == '+' || *p == '-')) {
+                negativeExp = (*p == '-');
+                ++p;
+            }
+            if (p == end) return false;
+            int e = 0;
+            for (; p != end && *p >= '0' && *p <= '9'; ++p) {
+                // saturate, anything beyond is an overflow or underflow anyway
+                if (e < 100000) e = e * 10 + (*p - '0');
+            }
+            exponent += negativeExp ? -e : e;
+        }
+        if (p != end) return false;
+
+        // fast path: both the significand and the power of ten are exact doubles
+        if (!truncated && mantissa <= (static_cast<uint64_t>(1) << 53) && exponent >= -22 && exponent <= 22) {
+            double v = static_cast<double>(mantissa);
+            v = (exponent < 0) ? v / powers[-exponent] : v * powers[exponent];
+            value = negative ? -v : v;
+            return true;
+        }
+
+        // slow path, correctly rounded by the standard library
+        std::istringstream ss(std::string(first, static_cast<size_t>(end - first)));
+        ss.imbue(std::locale::classic());
+        double v = 0.0;
+        ss >> v;
+        if (ss.fail()) {
+            // the syntax has been checked, so only a range error fails here; saturate like strtod
+            v = (exponent + digits > 0) ? std::numeric_limits<double>::infinity() : 0.0;
+            v = negative ? -v : v;
+        }
+        value = v;
+        return true;
+    }
+
+    bool NumberParser::toInt(double number, int& value)
+    {
+        // NaN fails the range check, the cast is only defined within the range
+        if (!(number >= std::numeric_limits<int>::min() && number <= std::numeric_limits<int>::max()) 
+                || number != std::floor(number)) {
+            return false;
+        }
+        value = static_cast<int>(number);
+        return true;
+    }
+
+    bool NumberParser::matchWord(const char* first, const char* last, const char* word)
+    {
+        for (; first != last && *word != '\0'; ++first, ++word) {
+            if (tolower(static_cast<unsigned char>(*first)) != *word) return false;
+        }
+        return first == last && *word == '\0';
+    }
+
+    void NumberParser::trim(const char*& first, const char*& last)
+    {
+        while (first != last && isspace(static_cast<unsigned char>(*first))) ++first;
+        while (last != first && isspace(static_cast<unsigned char>(*(last - 1)))) --last;
+    }
+
+    // AtomicCounter
+    AtomicCounter::AtomicCounter(size_t value) : _value(value)
+    {}
+
+    AtomicCounter::AtomicCounter(const AtomicCounter& other) : _value(other.load())
+    {}
+
+    AtomicCounter& AtomicCounter::operator=(const AtomicCounter& other)
+    {
+        store(other.load());
+        return *this;
+    }
+
+    size_t AtomicCounter::load(std::memory_order order) const
+    {
+        return _value.load(order);
+    }
+
+    void AtomicCounter::store(size_t value, std::memory_order order)
+    {
+        _value.store(value, order);
+    }
+
+#ifdef MINICONF_ARENA_SUPPORT
+    // Arena
+    Arena::Arena(size_t blockSize) : _blockSize(blockSize), _blocks(), _position(nullptr), _remaining(0), _used(0)
+    {}
+
+    char* Arena::allocate(size_t size)
+    {
+        const size_t alignment = sizeof(double);
+        size = (size + alignment - 1) & ~(alignment - 1);
+        if (size > _blockSize / 4) {
+            // a large buffer is not carved from the current block, it would waste the rest
+            _blocks.emplace_back(new char[size]);
+            _used += size;
+            return _blocks.back().get();
+        }
+        if (size > _remaining) {
+            _blocks.emplace_back(new char[_blockSize]);
+            _position = _blocks.back().get();
+            _remaining = _blockSize;
+        }
+        char* buffer = _position;
+        _position += size;
+        _remaining -= size;
+        _used += size;
+        return buffer;
+    }
+
+    size_t Arena::used() const
+    {
+        return _used;
+    }
+
+    Arena* Arena::active()
+    {
+        return current();
+    }
+
+    Arena* Arena::activate(Arena* arena)
+    {
+        Arena* previous = current();
+        current() = arena;
+        return previous;
+    }
+
+    Arena*& Arena::current()
+    {
+        static thread_local Arena* arena = nullptr;
+        return arena;
+    }
+#endif
+
+    // Value
+    Value::Value() : _type(DataType::UNKNOWN), _size(0), _data(nullptr)
+#ifdef MINICONF_ARENA_SUPPORT
+        , _arena(false)
+#endif
+    {}
+
+    Value::Value(const Value& other) : Value()
+    {
+        copyData(other._data, other._size, other._type);
+    }
+
+    Value::Value(Value&& other) : Value()
+    {
+        moveData(other);
+    }
+
+
+    Value& Value::operator=(const Value& other)
+    {
+        if (this == &other) {
+            return *this;
+        }
+        return copyData(other._data, other._size, other._type);
+    }
+
+    Value& Value::operator=(Value&& other)
+    {
+        if (this == &other) {
+            return *this;
+        }
+        return moveData(other);
+    }
+
+    Value::~Value()
+    {
+        clearData();
+    }
+
+    //  int
+    Value::Value(const int& other) : Value()
+    {
+        copyData(reinterpret_cast<const char*>(&other), sizeof(int), DataType::INT);
+    }
+
+    Value& Value::operator=(const int& other)
+    {
+        return copyData(reinterpret_cast<const char*>(&other), sizeof(int), DataType::INT);
+    }
 
     Value::operator int() const
     {
-        return *reinterpret_cast<int*>(_data);
+        return *reinterpret_cast<int*>(_data);
+    }
+
+    int Value::getInt() const
+    {
+        return *reinterpret_cast<int*>(_data);
+    }
+
+    //  number (floating point)
+    Value::Value(const double& other) : Value()
+    {
+        copyData(reinterpret_cast<const char*>(&other), sizeof(double), DataType::NUMBER);
+    }
+
+    Value& Value::operator=(const double& other)
+    {
+        return copyData(reinterpret_cast<const char*>(&other), sizeof(double), DataType::NUMBER);
+    }
+
+    Value::operator double() const
+    {
+        return *reinterpret_cast<double*>(_data);
+    }
+
+    double Value::getNumber() const
+    {
+        return *reinterpret_cast<double*>(_data);
+    }
+
+
+    //  bool
+    Value::Value(const bool& other) : Value()
+    {
+        copyData(reinterpret_cast<const char*>(&other), sizeof(bool), DataType::BOOL);
+    }
+
+    Value& Value::operator=(const bool& other)
+    {
+        return copyData(reinterpret_cast<const char*>(&other), sizeof(bool), DataType::BOOL);
+    }
+
+    Value::operator bool() const
+    {
+        return *reinterpret_cast<bool*>(_data);
+    }
+
+    bool Value::getBoolean() const
+    {
+        return *reinterpret_cast<bool*>(_data);
+    }
+
+    //  char array
+    Value::Value(const char* other) : Value()
+    {
+        copyData(other, strlen(other) + 1, DataType::STRING);
+    }
+
+    Value& Value::operator=(const char* other)
+    {
+        return copyData(other, strlen(other) + 1, DataType::STRING);
+    }
+
+    Value::operator char*() const
+    {
+        return getCharArray();
+    }
+
+    char* Value::getCharArray() const
+    {
+        return reinterpret_cast<char*>((_type == DataType::CHOICE) ? _data + sizeof(int) : _data);
+    }
+
+    //  std::string
+    Value::Value(const std::string& other) : Value()
+    {
+        copyData(other.c_str(), other.size() + 1, DataType::STRING);
+    }
+
+    Value& Value::operator=(const std::string& other)
+    {
+        return copyData(other.c_str(), other.size() + 1, DataType::STRING);
+    }
+
+    //  StringRef
+    Value::Value(const StringRef& other) : Value()
+    {
+        copyString(other.data(), other.size());
+    }
+
+    Value& Value::operator=(const StringRef& other)
+    {
+        return copyString(other.data(), other.size());
+    }
+
+    //  arrays
+    Value::Value(const std::vector<int>& other) : Value()
+    {
+        copyData(reinterpret_cast<const char*>(other.data()), other.size() * sizeof(int), DataType::INT_ARRAY);
+    }
+
+    Value::Value(const std::vector<double>& other) : Value()
+    {
+        copyData(reinterpret_cast<const char*>(other.data()), other.size() * sizeof(double), DataType::NUMBER_ARRAY);
+    }
+
+    Value::Value(const std::vector<bool>& other) : Value()
+    {
+        // std::vector<bool> is packed, the elements are copied one by one
+        copyData(nullptr, 0, DataType::BOOL_ARRAY);
+        if (!other.empty()) {
+            _data = (other.size() <= INLINE_SIZE) ? _buffer : allocate(other.size());
+            _size = other.size();
+            bool* elements = reinterpret_cast<bool*>(_data);
+            for (size_t i = 0; i < other.size(); ++i) {
+                elements[i] = other[i];
+            }
+        }
+    }
+
+    Value::Value(const std::vector<std::string>& other) : Value()
+    {
+        copyStrings(other.begin(), other.end());
+    }
+
+    Value::Value(const std::vector<StringRef>& other) : Value()
+    {
+        copyStrings(other.begin(), other.end());
+    }
+
+    Value::Value(const ArrayRef<int>& other) : Value()
+    {
+        copyData(reinterpret_cast<const char*>(other.data()), other.size() * sizeof(int), DataType::INT_ARRAY);
+    }
+
+    Value::Value(const ArrayRef<double>& other) : Value()
+    {
+        copyData(reinterpret_cast<const char*>(other.data()), other.size() * sizeof(double), DataType::NUMBER_ARRAY);
+    }
+
+    Value::Value(const ArrayRef<bool>& other) : Value()
+    {
+        copyData(reinterpret_cast<const char*>(other.data()), other.size() * sizeof(bool), DataType::BOOL_ARRAY);
+    }
+
+    Value Value::choice(int index, const StringRef& name)
+    {
+        // layout: the index, then the null-terminated name
+        Value v;
+        const size_t size = sizeof(int) + name.size() + 1;
+        v._data = (size <= INLINE_SIZE) ? v._buffer : v.allocate(size);
+        memcpy(v._data, &index, sizeof(int));
+        memcpy(v._data + sizeof(int), name.data(), name.size());
+        v._data[size - 1] = '\0';
+        v._type = DataType::CHOICE;
+        v._size = size;
+        return v;
+    }
+
+    ArrayRef<int> Value::getIntArray() const
+    {
+        return (_type == DataType::INT_ARRAY) ? ArrayRef<int>(reinterpret_cast<const int*>(_data), _size / sizeof(int)) : ArrayRef<int>();
+    }
+
+    ArrayRef<double> Value::getNumberArray() const
+    {
+        return (_type == DataType::NUMBER_ARRAY) ? ArrayRef<double>(reinterpret_cast<const double*>(_data), _size / sizeof(double)) : ArrayRef<double>();
+    }
+
+    ArrayRef<bool> Value::getBooleanArray() const
+    {
+        return (_type == DataType::BOOL_ARRAY) ? ArrayRef<bool>(reinterpret_cast<const bool*>(_data), _size / sizeof(bool)) : ArrayRef<bool>();
+    }
+
+    ArrayRef<StringRef> Value::getStringArray() const
+    {
+        return (_type == DataType::STRING_ARRAY) ? ArrayRef<StringRef>(_data) : ArrayRef<StringRef>();
+    }
+
+    size_t Value::arraySize() const
+    {
+        switch (_type) {
+            case DataType::INT_ARRAY:
+                return _size / sizeof(int);
+            case DataType::NUMBER_ARRAY:
+                return _size / sizeof(double);
+            case DataType::BOOL_ARRAY:
+                return _size / sizeof(bool);
+            case DataType::STRING_ARRAY:
+                return getStringArray().size();
+            default:
+                return 0;
+        }
+    }
+
+    Value Value::element(size_t i) const
+    {
+        switch (_type) {
+            case DataType::INT_ARRAY:
+                return Value(getIntArray()[i]);
+            case DataType::NUMBER_ARRAY:
+                return Value(getNumberArray()[i]);
+            case DataType::BOOL_ARRAY:
+                return Value(getBooleanArray()[i]);
+            case DataType::STRING_ARRAY:
+                return Value(getStringArray()[i]);
+            default:
+                return Value();
+        }
+    }
+
+    bool Value::isArray() const
+    {
+        return elementType(_type) != DataType::UNKNOWN;
+    }
+
+    Value::DataType Value::elementType(DataType arrayType)
+    {
+        switch (arrayType) {
+            case DataType::INT_ARRAY: return DataType::INT;
+            case DataType::NUMBER_ARRAY: return DataType::NUMBER;
+            case DataType::BOOL_ARRAY: return DataType::BOOL;
+            case DataType::STRING_ARRAY: return DataType::STRING;
+            default: return DataType::UNKNOWN;
+        }
+    }
+
+    Value::DataType Value::arrayType(DataType elementType)
+    {
+        switch (elementType) {
+            case DataType::INT: return DataType::INT_ARRAY;
+            case DataType::NUMBER: return DataType::NUMBER_ARRAY;
+            case DataType::BOOL: return DataType::BOOL_ARRAY;
+            case DataType::STRING: return DataType::STRING_ARRAY;
+            default: return DataType::UNKNOWN;
+        }
+    }
+
+    Value::operator std::string() const
+    {
+        return std::string(getCharArray());
+    }
+
+    std::string Value::getString() const
+    {
+        return std::string(getCharArray());
+    }
+
+    StringRef Value::getStringRef() const
+    {
+        // the buffer includes the terminating null character
+        if (_type == DataType::CHOICE) {
+            return StringRef(_data + sizeof(int), _size - sizeof(int) - 1);
+        }
+        return (_type == DataType::STRING && _size > 0) ? StringRef(_data, _size - 1) : StringRef();
+    }
+
+    // print function
+    std::string Value::print() const
+    {
+        const int slen = 31;
+        char tempStr[slen + 1];
+        std::string outStr;
+        switch (_type) {
+            case DataType::UNKNOWN:
+                snprintf(tempStr, slen, "null");
+                break;
+            case DataType::INT:
+                snprintf(tempStr, slen, "%d", getInt());
+                outStr = std::string(tempStr);
+                break;
+            case DataType::NUMBER:
+                snprintf(tempStr, slen, "%f", getNumber());
+                outStr = std::string(tempStr);
+                break;
+            case DataType::BOOL:
+                snprintf(tempStr, slen, "%s", getBoolean() ? "true" : "false");
+                outStr = std::string(tempStr);
+                break;
+            case DataType::STRING:
+            case DataType::CHOICE:
+                outStr = "\"" + std::string(getCharArray()) + "\"";
+                break;
+            case DataType::INT_ARRAY:
+            case DataType::NUMBER_ARRAY:
+            case DataType::BOOL_ARRAY:
+            case DataType::STRING_ARRAY:
+                outStr = "[";
+                for (size_t i = 0; i < arraySize(); ++i) {
+                    outStr += (i > 0 ? ", " : "") + element(i).print();
+                }
+                outStr += "]";
+                break;
+            default:
+                break;
+        }
+        return outStr;
+    }
+
+    // return data type
+    Value::DataType Value::type() const
+    {
+        return _type;
+    }
+
+    // compare data type and content
+    bool Value::operator==(const Value& other) const
+    {
+        return _type == other._type && _size == other._size && (_size == 0 || memcmp(_data, other._data, _size) == 0);
+    }
+
+    bool Value::operator!=(const Value& other) const
+    {
+        return !(*this == other);
+    }
+
+    // check empty
+    bool Value::isEmpty() const
+    {
+        return (_data == nullptr || _type == DataType::UNKNOWN);
+    }
+
+    // generate unknown value
+    Value Value::unknown()
+    {
+        return Value();
+    }
+
+    // print value data type
+    std::string Value::printType() const
+    {
+        std::string outStr;
+        const int slen = 15;
+        char tempStr[slen + 1];
+        switch (_type) {
+            case DataType::UNKNOWN:
+                snprintf(tempStr, slen, "UNKNOWN");
+                break;
+            case DataType::INT:
+                snprintf(tempStr, slen, "INT");
+                break;
+            case DataType::NUMBER:
+                snprintf(tempStr, slen, "NUMBER");
+                break;
+            case DataType::BOOL:
+                snprintf(tempStr, slen, "BOOLEAN");
+                break;
+            case DataType::STRING:
+                snprintf(tempStr, slen, "STRING");
+                break;
+            case DataType::INT_ARRAY:
+                snprintf(tempStr, slen, "INT[]");
+                break;
+            case DataType::NUMBER_ARRAY:
+                snprintf(tempStr, slen, "NUMBER[]");
+                break;
+            case DataType::BOOL_ARRAY:
+                snprintf(tempStr, slen, "BOOLEAN[]");
+                break;
+            case DataType::STRING_ARRAY:
+                snprintf(tempStr, slen, "STRING[]");
+                break;
+            case DataType::CHOICE:
+                snprintf(tempStr, slen, "CHOICE");
+                break;
+            default:
+                break;
+        }
+        return std::string(tempStr);
+    }
+
+    // move and copy function
+    Value& Value::moveData(Value& other)
+    {
+        if (!other.movable()) {
+            copyData(other._data, other._size, other._type);
+        } else {
+            clearData();
+            _type = other._type;
+            _size = other._size;
+            _data = other._data;
+#ifdef MINICONF_ARENA_SUPPORT
+            _arena = other._arena;
+            other._arena = false;
+#endif
+            other._data = nullptr;
+        }
+        other._type = DataType::UNKNOWN;
+        other.clearData();
+        return *this;
+    }
+
+    // internal use
+    Value& Value::copyData(const char* src, const size_t size, const DataType& type)
+    {
+        clearData();
+        // an empty array still points to the inline buffer, so it is not an empty Value
+        if (size > 0 || type != DataType::UNKNOWN) {
+            _data = (size <= INLINE_SIZE) ? _buffer : allocate(size);
+            if (size > 0) {
+                memcpy(_data, src, size);
+            }
+        }
+        _type = type;
+        _size = size;
+        return *this;
+    }
+
+    // internal use
+    Value& Value::copyString(const char* src, const size_t length)
+    {
+        // the source may refer to this value, copy it before the old data is released
+        const size_t size = length + 1;
+        if (size > INLINE_SIZE) {
+            Value copy;
+            copy._data = copy.allocate(size);
+            memcpy(copy._data, src, length);
+            copy._data[length] = '\0';
+            copy._type = DataType::STRING;
+            copy._size = size;
+            return moveData(copy);
+        }
+        memmove(_buffer, src, length);
+        clearData();
+        _data = _buffer;
+        _data[length] = '\0';
+        _type = DataType::STRING;
+        _size = size;
+        return *this;
+    }
+
+    // internal use
+    template <typename Iter>
+    Value& Value::copyStrings(Iter first, Iter last)
+    {
+        // layout: count, offsets of the elements and the end, then null-terminated characters
+        uint32_t count = static_cast<uint32_t>(std::distance(first, last));
+        size_t headerSize = sizeof(uint32_t) * (count + 2);
+        size_t size = headerSize;
+        for (Iter it = first; it != last; ++it) {
+            size += StringRef(*it).size() + 1;
+        }
+        clearData();
+        _data = (size <= INLINE_SIZE) ? _buffer : allocate(size);
+        _size = size;
+        _type = DataType::STRING_ARRAY;
+        memcpy(_data, &count, sizeof(uint32_t));
+        uint32_t offset = 0;
+        uint32_t index = 0;
+        for (Iter it = first; it != last; ++it, ++index) {
+            StringRef str(*it);
+            memcpy(_data + sizeof(uint32_t) * (index + 1), &offset, sizeof(uint32_t));
+            memcpy(_data + headerSize + offset, str.data(), str.size());
+            _data[headerSize + offset + str.size()] = '\0';
+            offset += static_cast<uint32_t>(str.size() + 1);
+        }
+        memcpy(_data + sizeof(uint32_t) * (count + 1), &offset, sizeof(uint32_t));
+        return *this;
+    }
+
+    // internal use
+    char* Value::allocate(size_t size)
+    {
+#ifdef MINICONF_ARENA_SUPPORT
+        Arena* active = Arena::active();
+        _arena = (active != nullptr);
+        if (active) {
+            return active->allocate(size);
+        }
+#endif
+        MINICONF_STATS(
+            AllocationStats& stats = allocationStats();
+            ++stats.count;
+            stats.bytes += size;
+        )
+        return new char[size];
+    }
+
+    // internal use
+    bool Value::movable() const
+    {
+        if (isInline()) {
+            return false;
+        }
+#ifdef MINICONF_ARENA_SUPPORT
+        // an arena buffer is only taken over while an arena is active, i.e. by the Config
+        // owning the arena, otherwise it could outlive the arena
+        return !_arena || Arena::active();
+#else
+        return true;
+#endif
+    }
+
+#ifdef MINICONF_STATS_SUPPORT
+    // StopWatch
+    StopWatch::StopWatch() : _start(std::chrono::steady_clock::now())
+    {}
+
+    double StopWatch::lap()
+    {
+        std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+        double elapsed = std::chrono::duration<double>(now - _start).count();
+        _start = now;
+        return elapsed;
+    }
+
+    AllocationStats& Value::allocationStats()
+    {
+        static thread_local AllocationStats stats = { 0, 0 };
+        return stats;
+    }
+#endif
+
+    // internal use
+    void Value::clearData()
+    {
+#ifdef MINICONF_ARENA_SUPPORT
+        if (_arena) {
+            _data = nullptr;
+            _arena = false;
+        }
+#endif
+        if (_data != nullptr && !isInline()) {
+            delete[] _data;
+        }
+        _data = nullptr;
+        _size = 0;
+    }
+
+    // internal use
+    bool Value::isInline() const
+    {
+        return _data == _buffer;
+    }
+
+    // FlagIndex
+    FlagIndex::FlagIndex() : _entries(), _count(0)
+    {
+        reset(0);
+    }
+
+    void FlagIndex::reset(size_t count)
+    {
+        // keep the load factor below 50%
+        size_t capacity = 16;
+        while (capacity < count * 2) {
+            capacity *= 2;
+        }
+        _entries.assign(capacity, Entry{0, NO_SLOT});
+        _count = 0;
+    }
+
+    template <typename KeyOf>
+    size_t FlagIndex::find(const StringRef& flag, const KeyOf& keyOf) const
+    {
+        return find(flag, hash(flag), keyOf);
+    }
+
+    template <typename KeyOf>
+    size_t FlagIndex::insert(const StringRef& flag, size_t slot, const KeyOf& keyOf)
+    {
+        return insert(flag, hash(flag), slot, keyOf);
+    }
+
+    template <typename KeyOf>
+    size_t FlagIndex::find(const StringRef& flag, uint64_t hash, const KeyOf& keyOf) const
+    {
+        return _entries[probe(flag, hash, keyOf)].slot;
+    }
+
+    template <typename KeyOf>
+    size_t FlagIndex::insert(const StringRef& flag, uint64_t hash, size_t slot, const KeyOf& keyOf)
+    {
+        if ((_count + 1) * 2 > _entries.size()) {
+            // grow the table, existing flags are distinct so only the hash is compared
+            std::vector<Entry> oldEntries;
+            oldEntries.swap(_entries);
+            size_t count = _count;
+            reset(count + 1);
+            size_t mask = _entries.size() - 1;
+            for (auto && e : oldEntries) {
+                if (e.slot != NO_SLOT) {
+                    size_t i = static_cast<size_t>(e.hash) & mask;
+                    while (_entries[i].slot != NO_SLOT) {
+                        i = (i + 1) & mask;
+                    }
+                    _entries[i] = e;
+                }
+            }
+            _count = count;
+        }
+        Entry& e = _entries[probe(flag, hash, keyOf)];
+        if (e.slot != NO_SLOT) {
+            return e.slot;
+        }
+        e = Entry{hash, slot};
+        ++_count;
+        return NO_SLOT;
+    }
+
+    uint64_t FlagIndex::hash(const StringRef& flag)
+    {
+        uint64_t h = 14695981039346656037ULL;
+        const char* data = flag.data();
+        for (size_t i = 0; i < flag.size(); ++i) {
+            h ^= static_cast<unsigned char>(data[i]);
+            h *= 1099511628211ULL;
+        }
+        return h;
+    }
+
+    template <typename KeyOf>
+    size_t FlagIndex::probe(const StringRef& flag, uint64_t hash, const KeyOf& keyOf) const
+    {
+        // linear probing, the table always contains empty entries
+        size_t mask = _entries.size() - 1;
+        size_t i = static_cast<size_t>(hash) & mask;
+        while (_entries[i].slot != NO_SLOT) {
+            const Entry& e = _entries[i];
+            if (e.hash == hash && keyOf(e.slot) == flag) {
+                break;
+            }
+            i = (i + 1) & mask;
+        }
+        return i;
+    }
+
+    // FlagTrie
+    FlagTrie::FlagTrie() : _nodes(), _offsets(), _chars()
+    {
+        build(std::vector<std::string>());
+    }
+
+    void FlagTrie::build(std::vector<std::string> words)
+    {
+        std::sort(words.begin(), words.end());
+        words.erase(std::unique(words.begin(), words.end()), words.end());
+        _chars.clear();
+        _offsets.clear();
+        for (auto && word : words) {
+            _offsets.push_back(static_cast<uint32_t>(_chars.size()));
+            _chars += word;
+        }
+        _offsets.push_back(static_cast<uint32_t>(_chars.size()));
+        _nodes.clear();
+        _nodes.push_back(Node{0, 0, 0, static_cast<uint32_t>(words.size()), 0});
+        buildChildren(0);
+    }
+
+    void FlagTrie::buildChildren(size_t node)
+    {
+        const size_t depth = _nodes[node].depth;
+        size_t i = _nodes[node].first;
+        const size_t last = _nodes[node].last;
+        // the word equal to the prefix, if any, comes first
+        if (i < last && _offsets[i + 1] - _offsets[i] == depth) {
+            ++i;
+        }
+        const size_t firstChild = _nodes.size();
+        while (i < last) {
+            // the words sharing the next character form a child, which keeps their common prefix
+            size_t end = i + 1;
+            while (end < last && at(end, depth) == at(i, depth)) {
+                ++end;
+            }
+            size_t childDepth = depth + 1;
+            const size_t shortest = std::min(_offsets[i + 1] - _offsets[i], _offsets[end] - _offsets[end - 1]);
+            while (childDepth < shortest && at(i, childDepth) == at(end - 1, childDepth)) {
+                ++childDepth;
+            }
+            _nodes.push_back(Node{0, 0, static_cast<uint32_t>(i), static_cast<uint32_t>(end), static_cast<uint32_t>(childDepth)});
+            i = end;
+        }
+        const size_t childCount = _nodes.size() - firstChild;
+        _nodes[node].firstChild = static_cast<uint32_t>(firstChild);
+        _nodes[node].childCount = static_cast<uint32_t>(childCount);
+        for (size_t child = firstChild; child < firstChild + childCount; ++child) {
+            buildChildren(child);
+        }
+    }
+
+    size_t FlagTrie::size() const
+    {
+        return _offsets.size() - 1;
+    }
+
+    StringRef FlagTrie::word(size_t i) const
+    {
+        return StringRef(_chars.data() + _offsets[i], _offsets[i + 1] - _offsets[i]);
+    }
+
+    unsigned char FlagTrie::at(size_t word, size_t i) const
+    {
+        return static_cast<unsigned char>(_chars[_offsets[word] + i]);
+    }
+
+    std::pair<size_t, size_t> FlagTrie::find(const StringRef& prefix) const
+    {
+        size_t node = 0;
+        while (prefix.size() > _nodes[node].depth) {
+            // binary search of the child by its first character
+            const size_t depth = _nodes[node].depth;
+            const unsigned char c = static_cast<unsigned char>(prefix.data()[depth]);
+            size_t low = _nodes[node].firstChild;
+            size_t high = low + _nodes[node].childCount;
+            while (low < high) {
+                size_t mid = (low + high) / 2;
+                if (at(_nodes[mid].first, depth) < c) {
+                    low = mid + 1;
+                } else {
+                    high = mid;
+                }
+            }
+            if (low == _nodes[node].firstChild + _nodes[node].childCount || at(_nodes[low].first, depth) != c) {
+                return std::make_pair(size_t(0), size_t(0));
+            }
+            // the rest of the merged chain is compared with the first word of the child
+            const size_t end = std::min<size_t>(prefix.size(), _nodes[low].depth);
+            if (memcmp(prefix.data() + depth + 1, _chars.data() + _offsets[_nodes[low].first] + depth + 1, end - depth - 1) != 0) {
+                return std::make_pair(size_t(0), size_t(0));
+            }
+            node = low;
+        }
+        return std::make_pair(size_t(_nodes[node].first), size_t(_nodes[node].last));
+    }
+
+    std::vector<std::string> FlagTrie::complete(const StringRef& prefix) const
+    {
+        std::vector<std::string> candidates;
+        std::pair<size_t, size_t> range = find(prefix);
+        for (size_t i = range.first; i < range.second;) {
+            StringRef w = word(i);
+            const char* dot = static_cast<const char*>(memchr(w.data() + prefix.size(), '.', w.size() - prefix.size()));
+            if (!dot) {
+                candidates.push_back(w.str());
+                ++i;
+                continue;
+            }
+            // the words of the segment are skipped at once
+            StringRef segment(w.data(), dot - w.data() + 1);
+            candidates.push_back(segment.str());
+            i = std::max(i + 1, find(segment).second);
+        }
+        return candidates;
+    }
+
+    std::string FlagTrie::serialize() const
+    {
+        Header header;
+        memcpy(header.magic, "MINITRIE", 8);
+        header.version = 1;
+        header.byteOrder = 0x01020304;
+        header.nodeCount = static_cast<uint32_t>(_nodes.size());
+        header.wordCount = static_cast<uint32_t>(size());
+        header.charsSize = static_cast<uint32_t>(_chars.size());
+        header.reserved = 0;
+        std::string out;
+        Writer writer(out);
+        writer.write(reinterpret_cast<const char*>(&header), sizeof(Header));
+        writer.write(reinterpret_cast<const char*>(_nodes.data()), _nodes.size() * sizeof(Node));
+        writer.write(reinterpret_cast<const char*>(_offsets.data()), _offsets.size() * sizeof(uint32_t));
+        writer.write(_chars.data(), _chars.size());
+        return out;
+    }
+
+    bool FlagTrie::deserialize(const StringRef& content)
+    {
+        Header header;
+        if (content.size() < sizeof(Header)) {
+            return false;
+        }
+        memcpy(&header, content.data(), sizeof(Header));
+        if (memcmp(header.magic, "MINITRIE", 8) != 0 || header.version != 1 || header.byteOrder != 0x01020304) {
+            return false;
+        }
+        const uint64_t nodesSize = static_cast<uint64_t>(header.nodeCount) * sizeof(Node);
+        const uint64_t offsetsSize = (static_cast<uint64_t>(header.wordCount) + 1) * sizeof(uint32_t);
+        if (header.nodeCount == 0 || sizeof(Header) + nodesSize + offsetsSize + header.charsSize != content.size()) {
+            return false;
+        }
+        std::vector<Node> nodes(header.nodeCount);
+        std::vector<uint32_t> offsets(header.wordCount + 1);
+        const char* pos = content.data() + sizeof(Header);
+        memcpy(nodes.data(), pos, nodesSize);
+        memcpy(offsets.data(), pos + nodesSize, offsetsSize);
+        // the queries trust the layout, so every index is checked once
+        if (offsets[0] != 0 || offsets.back() != header.charsSize) {
+            return false;
+        }
+        for (size_t i = 0; i < header.wordCount; ++i) {
+            if (offsets[i] > offsets[i + 1]) {
+                return false;
+            }
+        }
+        for (auto && node : nodes) {
+            if (static_cast<uint64_t>(node.firstChild) + node.childCount > header.nodeCount ||
+                    node.first > node.last || node.last > header.wordCount ||
+                    (node.childCount > 0 && node.firstChild == 0)) {
+                return false;
+            }
+            for (uint32_t i = node.first; i < node.last; ++i) {
+                if (offsets[i + 1] - offsets[i] < node.depth) {
+                    return false;
+                }
+            }
+            for (uint32_t i = node.firstChild; i < node.firstChild + node.childCount; ++i) {
+                if (nodes[i].depth <= node.depth || nodes[i].first == nodes[i].last) {
+                    return false;
+                }
+            }
+        }
+        _nodes.swap(nodes);
+        _offsets.swap(offsets);
+        _chars.assign(pos + nodesSize + offsetsSize, header.charsSize);
+        return true;
+    }
+
+    bool FlagTrie::save(const std::string& path) const
+    {
+        FILE* fd = fopen(path.c_str(), "wb");
+        if (!fd) {
+            return false;
+        }
+        std::string content = serialize();
+        bool good = fwrite(content.data(), 1, content.size(), fd) == content.size();
+        return (fclose(fd) == 0) && good;
+    }
+
+    bool FlagTrie::load(const std::string& path)
+    {
+        FileBuffer file(path);
+        return file.good() && deserialize(file.content());
+    }
+
+    // FlatTable
+    template <typename O>
+    FlatTable<O>::FlatTable() :
+        _arena(),
+        _keys(),
+        _presence(),
+        _options(),
+        _values(),
+        _index(),
+        _sorted(),
+        _optionSlots(),
+        _valueSlots(),
+        _optionSlotsValid(true),
+        _valueSlotsValid(true)
+    {}
+
+    template <typename O>
+    size_t FlatTable<O>::size() const
+    {
+        return _keys.size();
+    }
+
+    template <typename O>
+    void FlatTable<O>::clear()
+    {
+        _arena.clear();
+        _keys.clear();
+        _presence.clear();
+        _options.clear();
+        _values.clear();
+        _index.reset(0);
+        _sorted.clear();
+        _optionSlots.clear();
+        _valueSlots.clear();
+        _optionSlotsValid = true;
+        _valueSlotsValid = true;
+    }
+
+    template <typename O>
+    size_t FlatTable<O>::find(const StringRef& flag) const
+    {
+        return _index.find(flag, [this](size_t slot) { return key(slot); });
+    }
+
+    template <typename O>
+    size_t FlatTable<O>::insert(const StringRef& flag)
+    {
+        return insert(flag, FlagIndex::hash(flag));
+    }
+
+    template <typename O>
+    size_t FlatTable<O>::insert(const StringRef& flag, uint64_t hash)
+    {
+        size_t slot = _index.find(flag, hash, [this](size_t s) { return key(s); });
+        if (slot != NO_SLOT) {
+            return slot;
+        }
+        slot = _keys.size();
+        _keys.push_back(Key{_arena.size(), flag.size()});
+        _arena.insert(_arena.end(), flag.data(), flag.data() + flag.size());
+        _arena.push_back('\0');
+        _presence.push_back(0);
+        _options.emplace_back();
+        _values.emplace_back();
+        _index.insert(flag, hash, slot, [this](size_t s) { return key(s); });
+        return slot;
+    }
+
+    template <typename O>
+    StringRef FlatTable<O>::key(size_t slot) const
+    {
+        return StringRef(&_arena[_keys[slot].offset], _keys[slot].length);
+    }
+
+    template <typename O>
+    bool FlatTable<O>::hasOption(size_t slot) const
+    {
+        return (_presence[slot] & HAS_OPTION) != 0;
+    }
+
+    template <typename O>
+    bool FlatTable<O>::hasValue(size_t slot) const
+    {
+        return (_presence[slot] & HAS_VALUE) != 0;
+    }
+
+    template <typename O>
+    void FlatTable<O>::setOption(size_t slot, bool present)
+    {
+        if (present != hasOption(slot)) {
+            _presence[slot] ^= HAS_OPTION;
+            _optionSlotsValid = false;
+        }
+        if (!present) {
+            _options[slot] = O();
+        }
+    }
+
+    template <typename O>
+    void FlatTable<O>::setValue(size_t slot, bool present)
+    {
+        if (present != hasValue(slot)) {
+            _presence[slot] ^= HAS_VALUE;
+            _valueSlotsValid = false;
+        }
+        if (!present) {
+            _values[slot] = Value();
+        }
+    }
+
+    template <typename O>
+    O& FlatTable<O>::option(size_t slot)
+    {
+        return _options[slot];
+    }
+
+    template <typename O>
+    const O& FlatTable<O>::option(size_t slot) const
+    {
+        return _options[slot];
+    }
+
+    template <typename O>
+    Value& FlatTable<O>::value(size_t slot)
+    {
+        return _values[slot];
+    }
+
+    template <typename O>
+    const Value& FlatTable<O>::value(size_t slot) const
+    {
+        return _values[slot];
+    }
+
+    template <typename O>
+    size_t FlatTable<O>::findOption(const StringRef& flag) const
+    {
+        size_t slot = find(flag);
+        return (slot != NO_SLOT && hasOption(slot)) ? slot : NO_SLOT;
+    }
+
+    template <typename O>
+    size_t FlatTable<O>::findValue(const StringRef& flag) const
+    {
+        size_t slot = find(flag);
+        return (slot != NO_SLOT && hasValue(slot)) ? slot : NO_SLOT;
+    }
+
+    template <typename O>
+    const std::vector<size_t>& FlatTable<O>::options()
+    {
+        if (!_optionSlotsValid || _sorted.size() != _keys.size()) {
+            collect(_optionSlots, HAS_OPTION);
+            _optionSlotsValid = true;
+        }
+        return _optionSlots;
+    }
+
+    template <typename O>
+    const std::vector<size_t>& FlatTable<O>::values()
+    {
+        if (!_valueSlotsValid || _sorted.size() != _keys.size()) {
+            collect(_valueSlots, HAS_VALUE);
+            _valueSlotsValid = true;
+        }
+        return _valueSlots;
+    }
+
+    template <typename O>
+    void FlatTable<O>::sortSlots()
+    {
+        // sort the new slots and merge them into the sorted slots
+        size_t sortedCount = _sorted.size();
+        if (sortedCount == _keys.size()) {
+            return;
+        }
+        for (size_t slot = sortedCount; slot < _keys.size(); ++slot) {
+            _sorted.push_back(slot);
+        }
+        auto less = [this](size_t a, size_t b) {
+            StringRef ka = key(a);
+            StringRef kb = key(b);
+            int cmp = memcmp(ka.data(), kb.data(), std::min(ka.size(), kb.size()));
+            return (cmp != 0) ? (cmp < 0) : (ka.size() < kb.size());
+        };
+        std::sort(_sorted.begin() + sortedCount, _sorted.end(), less);
+        std::inplace_merge(_sorted.begin(), _sorted.begin() + sortedCount, _sorted.end(), less);
+    }
+
+    template <typename O>
+    void FlatTable<O>::collect(std::vector<size_t>& slots, unsigned char presence)
+    {
+        sortSlots();
+        slots.clear();
+        for (auto && slot : _sorted) {
+            if (_presence[slot] & presence) {
+                slots.push_back(slot);
+            }
+        }
+    }
+
+    // ValueLayer
+    ValueLayer::ValueLayer(const std::string& name) : _name(name), _values(std::make_shared<Values>()), _sortedCount(0)
+    {}
+
+    const std::string& ValueLayer::name() const
+    {
+        return _name;
+    }
+
+    Value& ValueLayer::set(size_t slot)
+    {
+        own();
+        _values->push_back(std::make_pair(slot, Value()));
+        return _values->back().second;
+    }
+
+    const Value* ValueLayer::find(size_t slot)
+    {
+        sort();
+        return find(*_values, slot);
+    }
+
+    const Value* ValueLayer::find(const Values& values, size_t slot)
+    {
+        auto it = std::lower_bound(values.begin(), values.end(), slot, 
+                [](const std::pair<size_t, Value>& v, size_t s) { return v.first < s; });
+        return (it != values.end() && it->first == slot) ? &it->second : nullptr;
+    }
+
+    void ValueLayer::clear()
+    {
+        if (_values.use_count() > 1) {
+            _values = std::make_shared<Values>();
+        } else {
+            _values->clear();
+        }
+        _sortedCount = 0;
+    }
+
+#ifdef MINICONF_ARENA_SUPPORT
+    void ValueLayer::copyValues()
+    {
+        if (_values.use_count() > 1) {
+            // the copy of shared values is allocated from the active arena already
+            own();
+            return;
+        }
+        for (auto && value : *_values) {
+            value.second = Value(value.second);
+        }
+    }
+#endif
+
+    std::shared_ptr<const ValueLayer::Values> ValueLayer::share()
+    {
+        sort();
+        return _values;
+    }
+
+    void ValueLayer::sort()
+    {
+        if (_sortedCount == _values->size()) {
+            return;
+        }
+        own();
+        Values& values = *_values;
+        size_t maxSlot = 0;
+        for (auto && value : values) {
+            maxSlot = std::max(maxSlot, value.first);
+        }
+        // the position of the last value of each slot is found, then each value is moved once
+        Values sorted;
+        if (maxSlot < 4 * values.size()) {
+            // slots are dense, they are counted instead of compared
+            std::vector<size_t> last(maxSlot + 1, NO_SLOT);
+            for (size_t i = 0; i < values.size(); ++i) {
+                last[values[i].first] = i;
+            }
+            sorted.reserve(values.size());
+            for (auto && position : last) {
+                if (position != NO_SLOT) {
+                    sorted.push_back(std::move(values[position]));
+                }
+            }
+        } else {
+            // the positions keep the values of a slot in the order they were added
+            std::vector<std::pair<size_t, size_t> > order(values.size());
+            for (size_t i = 0; i < values.size(); ++i) {
+                order[i] = std::make_pair(values[i].first, i);
+            }
+            std::sort(order.begin(), order.end());
+            sorted.reserve(order.size());
+            for (size_t i = 0; i < order.size(); ++i) {
+                if (i + 1 < order.size() && order[i + 1].first == order[i].first) {
+                    continue;
+                }
+                sorted.push_back(std::move(values[order[i].second]));
+            }
+        }
+        values.swap(sorted);
+        _sortedCount = values.size();
+    }
+
+    void ValueLayer::own()
+    {
+        if (_values.use_count() > 1) {
+            _values = std::make_shared<Values>(*_values);
+        }
+    }
+
+    // OptionSpec
+    constexpr OptionSpec::OptionSpec(const char* flag, const char* shortflag, int defaultValue, const char* description, bool required)
+        : flag(flag), shortflag(shortflag), description(description), type(Value::DataType::INT), intValue(defaultValue),
+        numberValue(0.0), boolValue(false), stringValue(nullptr), required(required), hash(Schema::hash(flag ? flag : "")),
+        shortflagHash(Schema::hash(shortflag ? shortflag : ""))
+    {}
+
+    constexpr OptionSpec::OptionSpec(const char* flag, const char* shortflag, double defaultValue, const char* description, bool required)
+        : flag(flag), shortflag(shortflag), description(description), type(Value::DataType::NUMBER), intValue(0),
+        numberValue(defaultValue), boolValue(false), stringValue(nullptr), required(required), hash(Schema::hash(flag ? flag : "")),
+        shortflagHash(Schema::hash(shortflag ? shortflag : ""))
+    {}
+
+    constexpr OptionSpec::OptionSpec(const char* flag, const char* shortflag, bool defaultValue, const char* description, bool required)
+        : flag(flag), shortflag(shortflag), description(description), type(Value::DataType::BOOL), intValue(0),
+        numberValue(0.0), boolValue(defaultValue), stringValue(nullptr), required(required), hash(Schema::hash(flag ? flag : "")),
+        shortflagHash(Schema::hash(shortflag ? shortflag : ""))
+    {}
+
+    constexpr OptionSpec::OptionSpec(const char* flag, const char* shortflag, const char* defaultValue, const char* description, bool required)
+        : flag(flag), shortflag(shortflag), description(description), type(Value::DataType::STRING), intValue(0),
+        numberValue(0.0), boolValue(false), stringValue(defaultValue), required(required), hash(Schema::hash(flag ? flag : "")),
+        shortflagHash(Schema::hash(shortflag ? shortflag : ""))
+    {}
+
+    // Schema
+    template <size_t N>
+    constexpr bool Schema::uniqueFlags(const OptionSpec (&specs)[N])
+    {
+        return defined(specs, 0, N, true) && distinct(specs, 0, N, false);
+    }
+
+    template <size_t N>
+    constexpr bool Schema::uniqueShortflags(const OptionSpec (&specs)[N])
+    {
+        return distinct(specs, 0, N, true);
+    }
+
+    template <size_t N>
+    constexpr bool Schema::defaultsDefined(const OptionSpec (&specs)[N])
+    {
+        return defined(specs, 0, N, false);
+    }
+
+    constexpr uint64_t Schema::hash(const char* flag, uint64_t h)
+    {
+        return *flag ? hash(flag + 1, (h ^ static_cast<unsigned char>(*flag)) * 1099511628211ULL) : h;
+    }
+
+    constexpr bool Schema::equal(const char* a, const char* b)
+    {
+        return *a == *b && (*a == '\0' || equal(a + 1, b + 1));
+    }
+
+    constexpr const char* Schema::key(const OptionSpec& spec, bool shortflag)
+    {
+        return shortflag ? (spec.shortflag ? spec.shortflag : "") : (spec.flag ? spec.flag : "");
+    }
+
+    constexpr bool Schema::distinct(const OptionSpec* specs, size_t first, size_t last, bool shortflag)
+    {
+        return last - first < 2 ? true :
+            distinct(specs, first, first + (last - first) / 2, shortflag) &&
+            distinct(specs, first + (last - first) / 2, last, shortflag) &&
+            disjoint(specs, first, first + (last - first) / 2, first + (last - first) / 2, last, shortflag);
+    }
+
+    constexpr bool Schema::disjoint(const OptionSpec* specs, size_t first, size_t last, size_t first2, size_t last2, bool shortflag)
+    {
+        return first == last ? true :
+            last - first > 1 ?
+                disjoint(specs, first, first + (last - first) / 2, first2, last2, shortflag) &&
+                disjoint(specs, first + (last - first) / 2, last, first2, last2, shortflag) :
+            excluded(specs, first, first2, last2, shortflag);
+    }
+
+    constexpr bool Schema::excluded(const OptionSpec* specs, size_t i, size_t first, size_t last, bool shortflag)
+    {
+        // the range is split until it is short enough for a linear scan
+        return first == last ? true :
+            last - first > 64 ?
+                excluded(specs, i, first, first + (last - first) / 2, shortflag) &&
+                excluded(specs, i, first + (last - first) / 2, last, shortflag) :
+            unequal(specs[i], specs[first], shortflag) && excluded(specs, i, first + 1, last, shortflag);
+    }
+
+    constexpr bool Schema::unequal(const OptionSpec& a, const OptionSpec& b, bool shortflag)
+    {
+        // the keys are only compared if their hashes match, empty short flags are not compared
+        return shortflag ? a.shortflagHash != b.shortflagHash || *key(a, true) == '\0' || !equal(key(a, true), key(b, true)) :
+            a.hash != b.hash || !equal(key(a, false), key(b, false));
+    }
+
+    constexpr bool Schema::defined(const OptionSpec* specs, size_t first, size_t last, bool flags)
+    {
+        return first == last ? true :
+            last - first > 1 ?
+                defined(specs, first, first + (last - first) / 2, flags) &&
+                defined(specs, first + (last - first) / 2, last, flags) :
+            flags ? *key(specs[first], false) != '\0' :
+            specs[first].type != Value::DataType::STRING || specs[first].stringValue != nullptr;
+    }
+
+    // Option
+    Config::Option::Option() : _flag(), _shortflag(), _description(), _defaultValue(Value::unknown()), _choices(), _required(false), _hidden(false), _schemaVersion(nullptr)
+    {}
+
+    Config::Option::~Option()
+    {}
+
+    Config::Option& Config::Option::flag(const std::string& flag)
+    {
+        _flag = flag;
+        modified();
+        return *this;
+    }
+
+    Config::Option& Config::Option::shortflag(const std::string& shortflag)
+    {
+        _shortflag = shortflag;
+        modified();
+        return *this;
+    }
+
+    Config::Option& Config::Option::description(const std::string& description)
+    {
+        _description = description;
+        modified();
+        return *this;
+    }
+
+    Config::Option& Config::Option::defaultValue(const Value& defaultValue)
+    {
+        _defaultValue = (_choices.empty() || defaultValue.type() != Value::DataType::STRING) ? defaultValue : choice(defaultValue.getStringRef());
+        modified();
+        return *this;
+    }
+
+    Config::Option& Config::Option::defaultValue(const int& defaultValue)
+    {
+        _defaultValue = static_cast<int>(defaultValue);
+        modified();
+        return *this;
+    }
+
+    Config::Option& Config::Option::defaultValue(const double& defaultValue)
+    {
+        _defaultValue = static_cast<double>(defaultValue);
+        modified();
+        return *this;
+    }
+
+    Config::Option& Config::Option::defaultValue(const bool& defaultValue)
+    {
+        _defaultValue = static_cast<bool>(defaultValue);
+        modified();
+        return *this;
+    }
+
+    Config::Option& Config::Option::defaultValue(const char* defaultValue)
+    {
+        _defaultValue = _choices.empty() ? Value(defaultValue) : choice(StringRef(defaultValue));
+        modified();
+        return *this;
+    }
+
+    Config::Option& Config::Option::defaultValue(const std::string& defaultValue)
+    {
+        _defaultValue = _choices.empty() ? Value(defaultValue) : choice(StringRef(defaultValue));
+        modified();
+        return *this;
+    }
+
+    Config::Option& Config::Option::defaultValue(const std::vector<int>& defaultValue)
+    {
+        _defaultValue = Value(defaultValue);
+        modified();
+        return *this;
+    }
+
+    Config::Option& Config::Option::defaultValue(const std::vector<double>& defaultValue)
+    {
+        _defaultValue = Value(defaultValue);
+        modified();
+        return *this;
+    }
+
+    Config::Option& Config::Option::defaultValue(const std::vector<bool>& defaultValue)
+    {
+        _defaultValue = Value(defaultValue);
+        modified();
+        return *this;
+    }
+
+    Config::Option& Config::Option::defaultValue(const std::vector<std::string>& defaultValue)
+    {
+        _defaultValue = Value(defaultValue);
+        modified();
+        return *this;
+    }
+
+    Config::Option& Config::Option::choices(const std::vector<std::string>& choices)
+    {
+        _choices = choices;
+        // a default name given before the choices is mapped now
+        const Value::DataType type = _defaultValue.type();
+        if (type == Value::DataType::STRING || type == Value::DataType::CHOICE) {
+            _defaultValue = choice(_defaultValue.getStringRef());
+        }
+        modified();
+        return *this;
+    }
+
+    Config::Option& Config::Option::required(const bool required)
+    {
+        _required = required;
+        modified();
+        return *this;
+    }
+
+    Config::Option& Config::Option::hidden(const bool hidden)
+    {
+        _hidden = hidden;
+        modified();
+        return *this;
+    }
+
+    const std::string& Config::Option::flag() const
+    {
+        return _flag;
+    }
+
+    const std::string& Config::Option::shortflag() const
+    {
+        return _shortflag;
+    }
+
+    const std::string& Config::Option::description() const
+    {
+        return _description;
+    }
+
+    const std::vector<std::string>& Config::Option::choices() const
+    {
+        return _choices;
+    }
+
+    Value Config::Option::choice(const StringRef& name) const
+    {
+        // the lists of choices are short, a linear search is faster than an index
+        for (size_t i = 0; i < _choices.size(); ++i) {
+            if (name == StringRef(_choices[i])) {
+                return Value::choice(static_cast<int>(i), name);
+            }
+        }
+        return Value::choice(-1, name);
+    }
+
+    const Value& Config::Option::defaultValue() const
+    {
+        return _defaultValue;
+    }
+
+    bool Config::Option::required() const
+    {
+        return _required;
+    }
+
+    bool Config::Option::hidden() const
+    {
+        return _hidden;
+    }
+
+    void Config::Option::modified()
+    {
+        if (_schemaVersion) {
+            _schemaVersion->fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    Value::DataType Config::Option::type() const
+    {
+        // a required choice has no default value
+        return _choices.empty() ? _defaultValue.type() : Value::DataType::CHOICE;
+    }
+
+    Config::Config() :
+        _table(),
+        _log(),
+        _logText(),
+        _logSink(),
+        _verbose(false),
+        _logLevel(Config::LogLevel::WARNING),
+        _exeName(""),
+        _usageText(),
+        _helpText(),
+        _helpVersion(0),
+        _flagTrie(),
+        _trieVersion(0),
+        _description(""),
+        _autoHelp(true),
+        _loadConfig(true),
+        _shortflagIndex(),
+        _indexVersion(0),
+        _schemaVersion(std::make_shared<std::atomic<size_t> >(1)),
+        _checkedVersion(0),
+        _checkFormatResult(Config::LogLevel::INFO),
+        _configPath(""),
+        _changeCallbacks(),
+        _snapshot(),
+        _snapshotVersion(0),
+        _layers(),
+        _loadingLayer(NO_SLOT),
+        _layerVersion(1),
+        _resolvedVersion(),
+#ifdef MINICONF_ARENA_SUPPORT
+        _arena(),
+        _arenaBlockSize(0),
+        _arenaLive(0),
+        _arenaDepth(0),
+#endif
+        _jsonMaxDepth(64),
+        _jsonMaxSize(64 << 20)
+#ifdef MINICONF_STATS_SUPPORT
+        , _stats()
+#endif
+    {
+        enableHelp(true); // set auto help to true
+        enableConfig(true); // set auto config to true
+    }
+
+    Config::~Config()
+    {
+        _table.clear();
+        _log.clear();
+    }
+
+    Config::Option& Config::option(const std::string& flag)
+    {
+        // the returned option bumps the schema version when it is modified, e.g. its short flag
+        size_t slot = _table.insert(flag);
+        if (!_table.hasOption(slot)) {
+            _table.setOption(slot, true);
+            _table.option(slot)._schemaVersion = _schemaVersion.get();
+            _table.option(slot).flag(flag);
+        }
+        return _table.option(slot);
+    }
+
+    template <size_t N>
+    void Config::schema(const OptionSpec (&specs)[N])
+    {
+        registerSchema(specs, N);
+    }
+
+    void Config::registerSchema(const OptionSpec* specs, size_t count)
+    {
+        _schemaVersion->fetch_add(1, std::memory_order_relaxed);
+        for (size_t i = 0; i < count; ++i) {
+            const OptionSpec& spec = specs[i];
+            // the hash is computed at compile time
+            size_t slot = _table.insert(StringRef(spec.flag), spec.hash);
+            _table.setOption(slot, false);
+            _table.setOption(slot, true);
+            Config::Option& o = _table.option(slot);
+            o._schemaVersion = _schemaVersion.get();
+            o.flag(spec.flag);
+            if (spec.shortflag) {
+                o.shortflag(spec.shortflag);
+            }
+            if (spec.description) {
+                o.description(spec.description);
+            }
+            switch (spec.type) {
+                case Value::DataType::INT: o.defaultValue(spec.intValue); break;
+                case Value::DataType::NUMBER: o.defaultValue(spec.numberValue); break;
+                case Value::DataType::BOOL: o.defaultValue(spec.boolValue); break;
+                default: o.defaultValue(spec.stringValue ? spec.stringValue : ""); break;
+            }
+            o.required(spec.required);
+        }
+    }
+
+    bool Config::remove(const std::string& flag)
+    {
+        size_t slot = _table.findOption(flag);
+        if (slot != NO_SLOT){
+            _table.setOption(slot, false); 
+            _schemaVersion->fetch_add(1, std::memory_order_relaxed);
+            return true; 
+        }
+        return false; 
+    }
+
+    void Config::setDefaultValues()
+    {
+        for (auto && slot : _table.options()) {
+            _table.value(slot) = _table.option(slot).defaultValue();
+            _table.setValue(slot, true);
+        }
+    }
+
+    void Config::log(const LogLevel logType)
+    {
+        _logLevel = logType;
+    }
+
+    void Config::log(FILE* fd)
+    {
+        fprintf(fd, "\n[[[  %s  ]]]\n\n", "PARSE LOG");
+        readLog([fd](const LogRecord& record) {
+            fprintf(fd, "%s\n", formatLog(record).c_str());
+        });
+    }
+
+    void Config::logSink(const LogSink& sink)
+    {
+        _logSink = sink;
+    }
+
+    void Config::readLog(const LogSink& reader) const
+    {
+        for (auto && entry : _log) {
+            LogRecord record = { entry.level, entry.code, 
+                StringRef(_logText.data() + entry.token, entry.tokenLength),
+                StringRef(_logText.data() + entry.detail, entry.detailLength) };
+            reader(record);
+        }
+    }
+
+    const char* Config::logMessage(LogCode code)
+    {
+        switch (code) {
+            case LogCode::DEFAULT_VALUE_UNDEFINED: return "default value is not defined";
+            case LogCode::DUPLICATE_SHORTFLAG: return "duplicate short flags (%s)";
+            case LogCode::NO_DESCRIPTION: return "no description text for argument";
+            case LogCode::NO_SHORTFLAG: return "no short flag is provided";
+            case LogCode::NO_PROGRAM_DESCRIPTION: return "No program description text is provided";
+            case LogCode::INVALID_VALUE: return "option contains invalid value";
+            case LogCode::UNDEFINED_OPTION: return "option is undefined";
+            case LogCode::INVALID_VALUE_TYPE: return "unvalid value type is provided";
+            case LogCode::VALUE_PARSED: return "value parsed successfully";
+            case LogCode::UNKNOWN_INPUT: return "unknown input";
+            case LogCode::UNRECOGNIZED_FLAG: return "unrecognized flag";
+            case LogCode::UNASSOCIATED_ARGUMENT: return "unassociated argument is not stored";
+            case LogCode::HANDLE_TYPE_MISMATCH: return "handle type does not match the option type";
+            case LogCode::CONFIG_UNREADABLE: return "unable to read config file";
+            case LogCode::NOTHING_TO_RELOAD: return "no config file has been loaded, nothing to reload";
+            case LogCode::RELOAD_FAILED: return "reload failed, previous values are restored";
+            case LogCode::VALUE_RELOADED: return "value is changed by reload";
+            case LogCode::BINARY_VERSION: return "Unsupported binary config version, abort";
+            case LogCode::BINARY_BYTE_ORDER: return "Binary config is written with a different byte order, abort";
+            case LogCode::BINARY_CORRUPTED: return "Binary config is truncated or corrupted, abort";
+            case LogCode::BINARY_SCHEMA_MISMATCH: return "Binary config is written with a different set of options";
+            case LogCode::BINARY_INVALID_FLAG: return "Binary config contains an invalid flag, abort";
+            case LogCode::BINARY_INVALID_ARRAY: return "binary config contains an invalid array, abort";
+            case LogCode::BINARY_INVALID_STRING: return "binary config contains an invalid string, abort";
+            case LogCode::BINARY_UNSUPPORTED_TYPE: return "unsupported value type in binary config";
+            case LogCode::BINARY_TYPE_MISMATCH: return "value type does not match the option type, ignored";
+            case LogCode::VALUE_LOADED: return "value is loaded from config";
+            case LogCode::STRAY_VALUE_LOADED: return "value is not defined in config, loaded as it is";
+            case LogCode::STRAY_VALUE_AS_STRING: return "value is not defined in config, parsed as a string value";
+            case LogCode::CONFIG_VALUE_INVALID: return "Unable to parse the option from config file.";
+            case LogCode::CONFIG_VALUE_TYPE_MISMATCH: return "Unable to parse the option from config file, flag = %s";
+            case LogCode::CONFIG_ARRAY_INVALID: return "Unable to parse the array from config file, elements must be numbers, booleans or strings of the same type.";
+            case LogCode::JSON_INVALID: return "Unable to parse JSON, abort, %s";
+            case LogCode::JSON_TOO_DEEP: return "JSON is nested deeper than %s levels, abort";
+            case LogCode::JSON_TOO_LARGE: return "JSON is larger than %s bytes, abort";
+            case LogCode::ENVIRONMENT_VALUE_LOADED: return "value is loaded from environment";
+            case LogCode::ENVIRONMENT_VALUE_INVALID: return "Unable to parse the option from environment variable.";
+            case LogCode::ENVIRONMENT_NAME_COLLISION: return "environment variable is also the name of option %s, it is not loaded";
+            case LogCode::INVALID_CHOICE: return "value is not a valid choice (%s)";
+            case LogCode::SHARED_UNAVAILABLE: return "Unable to publish to shared memory, %s";
+            case LogCode::SHARED_PUBLISHED: return "config is published to shared memory";
+        }
+        return "";
+    }
+
+    std::string Config::formatLog(const LogRecord& record)
+    {
+        const char* tag = "";
+        switch (record.level) {
+            case Config::LogLevel::INFO:
+                tag = "<<<     INFO>>>";
+                break;
+            case Config::LogLevel::WARNING:
+                tag = "<<<  WARNING>>>";
+                break;
+            case Config::LogLevel::ERROR:
+                tag = "<<<    ERROR>>>";
+                break;
+            default:
+                break;
+        }
+        // the detail is inserted in place of "%s" in the message text
+        const char* message = logMessage(record.code);
+        const char* marker = strstr(message, "%s");
+        std::string logString = std::string(tag) + " Input \"" + record.token.str() + "\" : ";
+        if (marker) {
+            logString.append(message, marker - message);
+            logString.append(record.detail.data(), record.detail.size());
+            logString.append(marker + 2);
+        } else {
+            logString.append(message);
+        }
+        return logString;
+    }
+
+    void Config::record(Config::LogLevel logType, LogCode code, const StringRef& token, const StringRef& detail)
+    {
+        Staging* stage = staging();
+        if (stage) {
+            // replayed by configFiles() in the order of the files
+            LogEntry entry = { logType, code, stage->logText.size(), token.size(), stage->logText.size() + token.size(), detail.size() };
+            stage->logText.append(token.data(), token.size());
+            stage->logText.append(detail.data(), detail.size());
+            stage->log.push_back(entry);
+            return;
+        }
+        LogRecord record = { logType, code, token, detail };
+        if (_verbose) {
+            fprintf(stdout, "%s\n", formatLog(record).c_str());
+        }
+        if (_logSink) {
+            _logSink(record);
+            return;
+        }
+        LogEntry entry = { logType, code, _logText.size(), token.size(), _logText.size() + token.size(), detail.size() };
+        _logText.append(token.data(), token.size());
+        _logText.append(detail.data(), detail.size());
+        _log.push_back(entry);
+    }
+
+    Config::TokenType Config::getTokenType(const char* token)
+    {
+        // get token type:
+        // starts with "--" - flag
+        // starts with "-" - shortflag/value
+        // otherwise value
+        if (token[0] == '\0') return TokenType::UNKNOWN;
+        if (token[0] == '-') {
+            // a negative number is a value, the parser rejects "-x" at its first character
+            double v;
+            if (NumberParser::parseNumber(StringRef(token), v)) {
+                return TokenType::VALUE;
+            }
+            return (token[1] == '-') ? TokenType::FLAG : TokenType::SHORTFLAG;
+        }
+        return TokenType::VALUE;
+    }
+    size_t Config::schemaVersion() const
+    {
+        return _schemaVersion->load(std::memory_order_relaxed);
+    }
+
+    void Config::buildIndex()
+    {
+        if (_indexVersion == schemaVersion()) {
+            return;
+        }
+        const std::vector<size_t>& slots = _table.options();
+        _shortflagIndex.reset(slots.size());
+        for (auto && slot : slots) {
+            const std::string& shortflag = _table.option(slot).shortflag();
+            if (!shortflag.empty()) {
+                // the first option (in flag order) takes the short flag
+                _shortflagIndex.insert(shortflag, slot, [this](size_t s) { return StringRef(_table.option(s).shortflag()); });
+            }
+        }
+        _indexVersion = schemaVersion();
+    }
+
+    size_t Config::findShortflag(const StringRef& shortflag)
+    {
+        buildIndex();
+        return _shortflagIndex.find(shortflag, [this](size_t s) { return StringRef(_table.option(s).shortflag()); });
+    }
+
+    size_t Config::translateShortflag(const char* shortflag, size_t length)
+    {
+        size_t slot = findShortflag(StringRef(shortflag, length));
+        if (slot != NO_SLOT) {
+            return slot;
+        }
+        // an undefined short flag may still be a long flag
+        return _table.findOption(StringRef(shortflag, length));
+    }
+
+    bool Config::findOption(const std::string& flag)
+    {
+        return _table.findOption(flag) != NO_SLOT;
+    }
+
+    Config::Option* Config::findFlag(const char* flag, size_t length)
+    {
+        size_t slot = _table.findOption(StringRef(flag, length));
+        return (slot != NO_SLOT) ? &_table.option(slot) : nullptr;
+    }
+
+    size_t Config::getOption(const char* token, Config::TokenType tokenType)
+    {
+        if (tokenType == TokenType::FLAG) {
+            return _table.findOption(StringRef(token + 2));
+        } else if (tokenType == TokenType::SHORTFLAG) {
+            return translateShortflag(token + 1, strlen(token + 1));
+        }
+        return NO_SLOT;
+    }
+
+    static bool isTrueWord(const StringRef& token)
+    {
+        return token == "true" || token == "True" || token == "TRUE" || token == "T" || token == "t";
+    }
+
+    static bool isFalseWord(const StringRef& token)
+    {
+        return token == "false" || token == "False" || token == "FALSE" || token == "F" || token == "f";
+    }
+
+    Value Config::parseArray(const std::vector<StringRef>& tokens, Value::DataType arrayType)
+    {
+        Value::DataType elementType = Value::elementType(arrayType);
+        if (elementType == Value::DataType::STRING) {
+            return Value(tokens);
+        }
+        if (elementType == Value::DataType::INT) {
+            std::vector<int> elements(tokens.size());
+            for (size_t i = 0; i < tokens.size(); ++i) {
+                if (!NumberParser::parseInt(tokens[i], elements[i])) return Value::unknown();
+            }
+            return Value(elements);
+        }
+        if (elementType == Value::DataType::NUMBER) {
+            std::vector<double> elements(tokens.size());
+            for (size_t i = 0; i < tokens.size(); ++i) {
+                if (!NumberParser::parseNumber(tokens[i], elements[i])) return Value::unknown();
+            }
+            return Value(elements);
+        }
+        if (elementType == Value::DataType::BOOL) {
+            // unlike a single value, an element which is neither true nor false is rejected
+            std::vector<bool> elements(tokens.size());
+            for (size_t i = 0; i < tokens.size(); ++i) {
+                if (!isTrueWord(tokens[i]) && !isFalseWord(tokens[i])) return Value::unknown();
+                elements[i] = isTrueWord(tokens[i]);
+            }
+            return Value(elements);
+        }
+        return Value::unknown(); // fool-proof, return an unknown
+    }
+
+    Value Config::parseValue(const StringRef& token, Value::DataType dataType)
+    {
+        if (dataType == Value::DataType::INT) {
+            int v;
+            return NumberParser::parseInt(token, v) ? Value(v) : Value::unknown();
+        }
+        if (dataType == Value::DataType::NUMBER) {
+            double v;
+            return NumberParser::parseNumber(token, v) ? Value(v) : Value();
+
+        }
+        if (dataType == Value::DataType::BOOL) {
+            if (isFalseWord(token)) {
+                return Value(false);
+            }
+            return Value(true);
+
+        }
+        if (dataType == Value::DataType::STRING) {
+            return Value(token);
+        }
+        return Value::unknown(); // fool-proof, return an unknown
+    }
+
+    static Config::LogLevel worseLevel(const Config::LogLevel& a, const Config::LogLevel& b)
+    {
+        return ((a) < (b)) ? (b) : (a);
+    }
+
+    static std::string joinChoices(const std::vector<std::string>& choices, const char* separator)
+    {
+        std::string joined;
+        for (size_t i = 0; i < choices.size(); ++i) {
+            if (i > 0) joined += separator;
+            joined += choices[i];
+        }
+        return joined;
+    }
+
+    Config::LogLevel Config::checkFormat()
+    {
+        if (_checkedVersion == schemaVersion()) {
+            return _checkFormatResult;
+        }
+        // the short flag index keeps the first option of each short flag
+        LogLevel errorLv = LogLevel::INFO;
+        for (auto && slot : _table.options()) {
+            const Option& o = _table.option(slot);
+            // check for error
+            if (!o.required() && o.defaultValue().isEmpty()) {
+                log(LogLevel::ERROR, LogCode::DEFAULT_VALUE_UNDEFINED, o.flag());
+                errorLv = worseLevel(errorLv, LogLevel::ERROR);
+            }
+            if (o.type() == Value::DataType::CHOICE && !o.defaultValue().isEmpty() && o.defaultValue().getInt() < 0) {
+                log(LogLevel::ERROR, LogCode::INVALID_CHOICE, o.flag(), joinChoices(o.choices(), ", "));
+                errorLv = worseLevel(errorLv, LogLevel::ERROR);
+            }
+            const std::string& shortflag = o.shortflag();
+            if (!shortflag.empty() && findShortflag(shortflag) != slot) {
+                log(LogLevel::ERROR, LogCode::DUPLICATE_SHORTFLAG, o.flag(), shortflag);
+                errorLv = worseLevel(errorLv, LogLevel::ERROR);
+            }
+            // check for warnings
+            if (o.description().empty()) {
+                log(LogLevel::WARNING, LogCode::NO_DESCRIPTION, o.flag());
+                errorLv = worseLevel(errorLv, LogLevel::WARNING);
+            }
+            if (shortflag.empty()) {
+                log(LogLevel::WARNING, LogCode::NO_SHORTFLAG, o.flag());
+                errorLv = worseLevel(errorLv, LogLevel::WARNING);
+            }
+        }
+        if (_description.empty()) {
+            log(LogLevel::WARNING, LogCode::NO_PROGRAM_DESCRIPTION, "");
+            errorLv = worseLevel(errorLv, LogLevel::WARNING);
+        }
+        _checkedVersion = schemaVersion();
+        _checkFormatResult = errorLv;
+        return errorLv;
+    }
+
+    // Validate User Input
+    Config::LogLevel Config::validate()
+    {
+        LogLevel errorLv = LogLevel::INFO;
+
+        // a name which is not a choice of the option is stored with the index -1
+        auto checkChoice = [&](size_t slot, const Value& value) {
+            if (value.type() == Value::DataType::CHOICE && value.getInt() < 0) {
+                log(LogLevel::ERROR, LogCode::INVALID_CHOICE, _table.key(slot),
+                        _table.hasOption(slot) ? joinChoices(_table.option(slot).choices(), ", ") : std::string());
+                errorLv = worseLevel(errorLv, LogLevel::ERROR);
+            }
+        };
+
+        // the values are resolved on access, the layers and default values are checked without resolving them
+        if (!_layers.empty()) {
+            for (auto && slot : _table.options()) {
+                const Option& o = _table.option(slot);
+                if (o.hidden()) {
+                    continue;
+                }
+                const Value* value = layerValue(slot);
+                if (value) {
+                    checkChoice(slot, *value);
+                }
+                if (o.defaultValue().isEmpty() && (!value || value->isEmpty())) {
+                    log(LogLevel::ERROR, LogCode::UNDEFINED_OPTION, _table.key(slot));
+                    errorLv = worseLevel(errorLv, LogLevel::ERROR);
+                }
+            }
+            return errorLv;
+        }
+
+        // remove all the hidden values
+        for (auto && slot : _table.options()){
+            if (_table.option(slot).hidden() && _table.hasValue(slot)){
+                _table.setValue(slot, false);
+            }
+        }
+
+        // scan for all option vlaues 
+        for (auto && slot : _table.values()) {
+            if (_table.value(slot).isEmpty()) {
+                log(LogLevel::ERROR, LogCode::INVALID_VALUE, _table.key(slot));
+                errorLv = worseLevel(errorLv, LogLevel::ERROR);
+            }
+            mapChoice(slot, _table.value(slot));
+            checkChoice(slot, _table.value(slot));
+        }
+
+        // scan for all remaining options are defined
+        for (auto && slot : _table.options()) {
+            if (!_table.hasValue(slot) && !_table.option(slot).hidden()) {
+                log(LogLevel::ERROR, LogCode::UNDEFINED_OPTION, _table.key(slot));
+                errorLv = worseLevel(errorLv, LogLevel::ERROR);
+            }
+        }
+        return errorLv;
+    }
+
+    bool Config::parse(int argc, char **argv)
+    {
+        MINICONF_STATS(
+            _stats = ParseStats();
+            StopWatch totalWatch;
+            StopWatch watch;
+            AllocationStats allocations = Value::allocationStats();
+        )
+
+        // check format of the option parser
+        // if fatal error occurs and log level is not "NONE" (NONE = ignore errors)
+        LogLevel checkFormatResult = checkFormat();
+        MINICONF_STATS(_stats.checkFormatTime = watch.lap();)
+        if (checkFormatResult >= LogLevel::ERROR && _logLevel <= LogLevel::ERROR) {
+            log();
+            printf("\nFatal Error: Option format validation failed, abort.\n\n");
+            return false;
+        }
+
+        // index the long and short flags for token lookup
+        buildIndex();
+        MINICONF_STATS(_stats.setupTime = watch.lap();)
+
+        LogLevel validateResult = parseArguments(argc, argv, _autoHelp);
+        MINICONF_STATS(watch.lap();)
+        publish();
+        MINICONF_STATS(
+            _stats.validateTime += watch.lap();
+            _stats.totalTime = totalWatch.lap();
+            _stats.allocations = Value::allocationStats().count - allocations.count;
+            _stats.allocatedBytes = Value::allocationStats().bytes - allocations.bytes;
+            _stats.options = _table.options().size();
+            _stats.arguments = static_cast<size_t>(std::max(argc - 1, 0));
+            _stats.values = _table.values().size();
+        )
+        if (validateResult >= LogLevel::ERROR && _logLevel <= LogLevel::ERROR) {
+            log();
+            printf("\nFatal Error: Option format validation failed, abort.\n\n");
+            return false;
+        }
+
+        return true;
+    }
+
+    size_t Config::parseBatch(const std::vector<std::vector<std::string> >& commandLines, const BatchCallback& callback)
+    {
+        // the format check and the flag index are shared by all the command lines
+        LogLevel checkFormatResult = checkFormat();
+        if (checkFormatResult >= LogLevel::ERROR && _logLevel <= LogLevel::ERROR) {
+            return 0;
+        }
+        buildIndex();
+
+        size_t parsed = 0;
+        std::vector<const char*> argv;
+        std::vector<size_t> previousValues;
+        for (size_t i = 0; i < commandLines.size(); ++i) {
+            // a command line without the executable name is not parsed
+            bool success = false;
+            if (!commandLines[i].empty()) {
+                argv.clear();
+                for (auto && argument : commandLines[i]) {
+                    argv.push_back(argument.c_str());
+                }
+                // values of the previous command line (e.g. stray values) are removed
+                previousValues.assign(_table.values().begin(), _table.values().end());
+                for (auto && slot : previousValues) {
+                    _table.setValue(slot, false);
+                }
+                _log.clear();
+                _logText.clear();
+                LogLevel validateResult = parseArguments(static_cast<int>(argv.size()), argv.data(), false);
+                success = validateResult < LogLevel::ERROR || _logLevel > LogLevel::ERROR;
+            }
+            if (success) {
+                ++parsed;
+            }
+            if (callback) {
+                callback(i, success);
+            }
+        }
+        publish();
+        return parsed;
+    }
+
+    Config::LogLevel Config::parseArguments(int argc, const char* const* argv, bool autoHelp)
+    {
+        ArenaScope scope(*this);
+        MINICONF_STATS(StopWatch watch;)
+
+        // Extract executable name
+        const char* exeName = argv[0];
+        const char* lastslash = strrchr(exeName, '/');
+        const char* lastbackslash = strrchr(exeName, '\\');
+        if (lastbackslash && (!lastslash || lastbackslash > lastslash)) {
+            lastslash = lastbackslash;
+        }
+        if (_exeName != (lastslash ? lastslash + 1 : exeName)) {
+            _exeName.assign(lastslash ? lastslash + 1 : exeName);
+            _helpVersion = 0;
+        }
+
+        // Value Precedence:
+        // (1) Default Value
+        // (2) Config File Settings (overwrites default values)
+        // (3) Command Line Arguments (overwrites default values and config file)
+
+        // * Set Default Values
+        // with layers, the default values are resolved on access and the arguments 
+        // (including the config files) are stored in the "arguments" layer
+        size_t argumentLayer = NO_SLOT;
+        if (_layers.empty()) {
+            setDefaultValues();
+        } else {
+            argumentLayer = findLayer("arguments");
+            if (argumentLayer == NO_SLOT) {
+                argumentLayer = addLayer("arguments");
+            }
+            _layers[argumentLayer].clear();
+            _loadingLayer = argumentLayer;
+        }
+        MINICONF_STATS(_stats.setupTime += watch.lap();)
+
+        // * Load Config File before scanning for other arguments
+        // case 1: only config file is defined, flag is not necessary
+        // case 2: check if config flag has been defined
+        if (_loadConfig) {
+            for (int i = 1; i < argc - 1; ++i) {
+                if ((strcmp(argv[i], "--config") == 0 || strcmp(argv[i], "-cfg") == 0) && 
+                        getTokenType(argv[i + 1]) == TokenType::VALUE) {
+                    config(argv[i + 1]);
+                }
+            }
+        }
+        MINICONF_STATS(_stats.configScanTime = watch.lap();)
+
+        // the option of the current flag, a flag which is not defined is stored as a string ("stray" value)
+        size_t currentSlot = NO_SLOT;
+        Value::DataType currentType = Value::DataType::UNKNOWN;
+        auto storeValue = [&](Value&& newValue, const StringRef& token) {
+            if (newValue.isEmpty()) {
+                log(LogLevel::WARNING, LogCode::INVALID_VALUE_TYPE, token);
+            } else {
+                valueAt(currentSlot) = std::move(newValue);
+                log(LogLevel::INFO, LogCode::VALUE_PARSED, token);
+            }
+        };
+
+        // an array option takes all the values until the next flag
+        std::vector<StringRef> arrayTokens;
+        auto storeArray = [&]() {
+            if (currentSlot != NO_SLOT && Value::elementType(currentType) != Value::DataType::UNKNOWN && !arrayTokens.empty()) {
+                storeValue(parseArray(arrayTokens, currentType), _table.key(currentSlot));
+            }
+            arrayTokens.clear();
+        };
+
+        // start normal parsing
+        for (int i = 1; i < argc; ++i) {
+            TokenType currentTokenType = getTokenType(argv[i]);
+            if (currentTokenType == TokenType::UNKNOWN) {
+                log(LogLevel::ERROR, LogCode::UNKNOWN_INPUT, argv[i]);
+            } else if (currentTokenType == TokenType::FLAG || currentTokenType == TokenType::SHORTFLAG) {
+                storeArray();
+                currentSlot = getOption(argv[i], currentTokenType);
+                currentType = Value::DataType::UNKNOWN;
+                if (currentSlot != NO_SLOT) {
+                    currentType = _table.option(currentSlot).type();
+                } else {
+                    log(LogLevel::WARNING, LogCode::UNRECOGNIZED_FLAG, argv[i]);
+                    if (currentTokenType == TokenType::FLAG) {
+                        currentSlot = _table.insert(argv[i] + 2);
+                        currentType = Value::DataType::STRING;
+                    }
+                }
+                // special case - if the option type is bool, set to true by default
+                if (currentType == Value::DataType::BOOL) {
+                    valueAt(currentSlot) = true;
+                }
+            } else if (currentTokenType == TokenType::VALUE) {
+                if (Value::elementType(currentType) != Value::DataType::UNKNOWN) {
+                    arrayTokens.push_back(argv[i]);
+                } else if (currentSlot != NO_SLOT) {
+                    // parse the value according to default data type, a choice is mapped to its index
+                    storeValue((currentType == Value::DataType::CHOICE) ?
+                            _table.option(currentSlot).choice(argv[i]) : parseValue(argv[i], currentType), argv[i]);
+                    // reset current option flag -> ready for a new flag
+                    currentSlot = NO_SLOT;
+                    currentType = Value::DataType::UNKNOWN;
+                } else {
+                    // stray arguments, ignore
+                    log(LogLevel::WARNING, LogCode::UNASSOCIATED_ARGUMENT, argv[i]);
+                }
+            }
+        }
+        storeArray();
+        MINICONF_STATS(_stats.argumentTime = watch.lap();)
+
+        // if contains help and auto-help is enabled, display help message
+        bool helpRequested = false;
+        if (argumentLayer == NO_SLOT) {
+            helpRequested = contains("help") && (*this)["help"].getBoolean();
+        } else {
+            _loadingLayer = NO_SLOT;
+            invalidate();
+            // "help" is a hidden option, it is read from the layer directly
+            const Value* helpValue = _layers[argumentLayer].find(_table.find("help"));
+            helpRequested = helpValue && helpValue->getBoolean();
+        }
+        if (autoHelp && helpRequested) {
+            help();
+        }
+
+        // validate user inputs
+        // remove all hidden options
+        // reserved words should not be displayed as normal config values
+        LogLevel validateResult = validate();
+        MINICONF_STATS(_stats.validateTime = watch.lap();)
+        return validateResult;
+    }
+
+    void Config::help(FILE* fd)
+    {
+        const std::string& text = helpText();
+        fwrite(text.data(), 1, text.size(), fd);
     }
 
-    int Value::getInt() const
+    void Config::usage(FILE* fd)
     {
-        return *reinterpret_cast<int*>(_data);
+        const std::string& text = usageText();
+        fwrite(text.data(), 1, text.size(), fd);
     }
 
-    //  number (floating point)
-    Value::Value(const double& other) : Value()
+    const std::string& Config::usageText()
     {
-        copyData(reinterpret_cast<const char*>(&other), sizeof(double), DataType::NUMBER);
+        renderHelp();
+        return _usageText;
     }
 
-    Value& Value::operator=(const double& other)
+    const std::string& Config::helpText()
     {
-        clearData();
-        return copyData(reinterpret_cast<const char*>(&other), sizeof(double), DataType::NUMBER);
+        renderHelp();
+        return _helpText;
     }
 
-    Value::operator double() const
+    void Config::renderHelp()
     {
-        return *reinterpret_cast<double*>(_data);
+        const size_t version = schemaVersion();
+        if (_helpVersion == version) {
+            return;
+        }
+        const std::vector<size_t>& slots = _table.options();
+
+        // usage
+        _usageText.clear();
+        Writer usage(_usageText);
+        usage.write("\n[[[  USAGE  ]]]\n\n");
+        const std::string exeTag = "    " + (_exeName.empty() ? std::string("<executable>") : _exeName) + " ";
+        usage.write(exeTag);
+        size_t lineWidth = 0;
+        for (auto && slot : slots) {
+            const Option& o = _table.option(slot);
+            std::string argTag = o.required() ? "" : "[";
+            argTag += o.shortflag().empty() ? "--" + o.flag() : "-" + o.shortflag();
+            argTag += " <" + (o.choices().empty() ? o.defaultValue().printType() : joinChoices(o.choices(), "|")) + ">";
+            argTag += o.required() ? "" : "]";
+            if (lineWidth + argTag.size() >= 80 - 1 - exeTag.size()) {
+                usage.put('\n');
+                usage.write(std::string(exeTag.size(), ' '));
+                lineWidth = 0;
+            }
+            usage.write(argTag);
+            usage.put(' ');
+            lineWidth += argTag.size();
+        }
+        usage.write("\n\n");
+
+        // the program description, the usage and the options
+        _helpText.clear();
+        Writer help(_helpText);
+        if (!_description.empty()) {
+            help.put('\n');
+            if (!_exeName.empty()) {
+                help.write("[[[  ");
+                help.write(_exeName);
+                help.write("  ]]]\n\n    ");
+            }
+            help.write(_description);
+            help.write("\n\n");
+        }
+        help.write(_usageText);
+        help.write("\n[[[  HELP  ]]]\n\n");
+        for (auto && slot : slots) {
+            const Option& o = _table.option(slot);
+            help.write("    ");
+            if (!o.shortflag().empty()) {
+                help.put('-');
+                help.write(o.shortflag());
+                help.write(", ");
+            }
+            help.write("--");
+            help.write(o.flag());
+            help.put(' ');
+            if (o.required()) {
+                help.write("<REQUIRED>");
+            }
+            help.write("\n        ");
+            if (!o.description().empty()) {
+                help.write(o.description());
+                help.put(' ');
+            }
+            if (!o.defaultValue().isEmpty() && !o.hidden()) {
+                help.write(" ( DEFAULT = ");
+                help.write(o.defaultValue().print());
+                help.write(" ) ");
+            }
+            help.write("\n\n");
+        }
+        _helpVersion = version;
     }
 
-    double Value::getNumber() const
+    const FlagTrie& Config::flagTrie()
     {
-        return *reinterpret_cast<double*>(_data);
+        if (_trieVersion != schemaVersion()) {
+            std::vector<std::string> words;
+            for (auto && slot : _table.options()) {
+                const Option& o = _table.option(slot);
+                words.push_back("--" + o.flag());
+                if (!o.shortflag().empty()) {
+                    words.push_back("-" + o.shortflag());
+                }
+            }
+            _flagTrie.build(std::move(words));
+            _trieVersion = schemaVersion();
+        }
+        return _flagTrie;
     }
 
+    std::vector<std::string> Config::complete(const std::string& word)
+    {
+        return flagTrie().complete(word);
+    }
 
-    //  bool
-    Value::Value(const bool& other) : Value()
+    std::string Config::completionScript(Shell shell, const std::string& command)
     {
-        copyData(reinterpret_cast<const char*>(&other), sizeof(bool), DataType::BOOL);
+        std::string name = !command.empty() ? command : (!_exeName.empty() ? _exeName : "program");
+        // the name of the bash function
+        std::string function = "_";
+        for (auto && c : name) {
+            function += isalnum(static_cast<unsigned char>(c)) ? c : '_';
+        }
+        // escapes a description in single quotes, zsh also requires escaped brackets and colons
+        auto quote = [shell](const std::string& text) {
+            std::string quoted;
+            for (auto && c : text) {
+                if (c == '\'') {
+                    quoted += (shell == Shell::FISH) ? "\\'" : "'\\''";
+                } else if (c == '\\' || (shell == Shell::ZSH && (c == '[' || c == ']' || c == ':'))) {
+                    quoted += '\\';
+                    quoted += c;
+                } else if (c == '\n') {
+                    quoted += ' ';
+                } else {
+                    quoted += c;
+                }
+            }
+            return quoted;
+        };
+
+        std::string out;
+        Writer script(out);
+        const std::vector<size_t>& slots = _table.options();
+        if (shell == Shell::BASH) {
+            script.write("# bash completion for " + name + ", generated by miniconf\n");
+            script.write(function + "()\n{\n    local cur=\"${COMP_WORDS[COMP_CWORD]}\"\n    COMPREPLY=($(compgen -W \"");
+            const FlagTrie& trie = flagTrie();
+            for (size_t i = 0; i < trie.size(); ++i) {
+                if (i > 0) script.put(' ');
+                script.write(trie.word(i));
+            }
+            script.write("\" -- \"$cur\"))\n}\ncomplete -F " + function + " " + name + "\n");
+        } else if (shell == Shell::ZSH) {
+            script.write("#compdef " + name + "\n# zsh completion for " + name + ", generated by miniconf\n_arguments");
+            for (auto && slot : slots) {
+                const Option& o = _table.option(slot);
+                // a value is expected after the flags of scalar options which are not boolean, a choice is completed
+                const Value::DataType type = o.type();
+                std::string argument;
+                if (type == Value::DataType::CHOICE) {
+                    argument = ":CHOICE:(" + quote(joinChoices(o.choices(), " ")) + ")";
+                } else if (type != Value::DataType::BOOL && Value::elementType(type) == Value::DataType::UNKNOWN) {
+                    argument = ":" + o.defaultValue().printType() + ":";
+                }
+                std::string description = "[" + quote(o.description()) + "]" + argument + "'";
+                script.write(" \\\n    '--" + o.flag() + description);
+                if (!o.shortflag().empty()) {
+                    script.write(" \\\n    '-" + o.shortflag() + description);
+                }
+            }
+            script.put('\n');
+        } else {
+            script.write("# fish completion for " + name + ", generated by miniconf\n");
+            for (auto && slot : slots) {
+                const Option& o = _table.option(slot);
+                script.write("complete -c " + name + " -l " + o.flag());
+                if (!o.shortflag().empty()) {
+                    // multi-character short flags, e.g. "-cfg", are old-style options in fish
+                    script.write((o.shortflag().size() == 1 ? " -s " : " -o ") + o.shortflag());
+                }
+                if (o.type() != Value::DataType::BOOL) {
+                    script.write(" -r");
+                }
+                if (o.type() == Value::DataType::CHOICE) {
+                    script.write(" -f -a '" + quote(joinChoices(o.choices(), " ")) + "'");
+                }
+                script.write(" -d '" + quote(o.description()) + "'\n");
+            }
+        }
+        return out;
     }
 
-    Value& Value::operator=(const bool& other)
+    void Config::description(const std::string& desc)
     {
-        clearData();
-        return copyData(reinterpret_cast<const char*>(&other), sizeof(bool), DataType::BOOL);
+        _description = desc;
+        _schemaVersion->fetch_add(1, std::memory_order_relaxed);
     }
 
-    Value::operator bool() const
+    void Config::enableConfig(bool enabled)
     {
-        return *reinterpret_cast<bool*>(_data);
+        _loadConfig = enabled;
+        if (_autoHelp && !findOption("config")) {
+            option("config").
+                shortflag("cfg").
+                defaultValue("").
+                description("Input configuration file (JSON/CSV)").
+                required(false).hidden(true);
+        } else {
+            remove("config");
+        }
+
     }
 
-    bool Value::getBoolean() const
+    void Config::enableHelp(bool enabled)
     {
-        return *reinterpret_cast<bool*>(_data);
+        _autoHelp = enabled;
+        if (_autoHelp && !findOption("help")) {
+            option("help").
+                shortflag("h").
+                defaultValue(false).
+                description("Display the help message").
+                required(false).hidden(true);
+        } else {
+            remove("help");
+        }
     }
 
-    //  char array
-    Value::Value(const char* other) : Value()
+    void Config::verbose(bool value)
     {
-        copyData(other, strlen(other) + 1, DataType::STRING);
+        _verbose = value;
+    }
+
+    bool Config::contains(const std::string& flag)
+    {
+        size_t slot = _table.find(flag);
+        if (slot == NO_SLOT) {
+            return false;
+        }
+        resolve(slot);
+        return _table.hasValue(slot);
+    }
+
+    Value& Config::operator[](const std::string& flag)
+    {
+        return valueOf(flag);
+    }
+
+    Value& Config::valueOf(const StringRef& flag)
+    {
+        Staging* stage = staging();
+        if (stage) {
+            // the table is shared by the loading threads, so no slot is created
+            size_t slot = _table.find(flag);
+            if (slot == NO_SLOT) {
+                stage->strays.emplace_back(std::string(flag.data(), flag.size()), Value());
+                return stage->strays.back().second;
+            }
+            return valueAt(slot);
+        }
+        return valueAt(_table.insert(flag));
+    }
+
+    Value& Config::valueAt(size_t slot)
+    {
+        Staging* stage = staging();
+        if (stage) {
+            stage->values.emplace_back(slot, Value());
+            return stage->values.back().second;
+        }
+        if (_loadingLayer != NO_SLOT) {
+            return _layers[_loadingLayer].set(slot);
+        }
+        resolve(slot);
+        _table.setValue(slot, true);
+        return _table.value(slot);
+    }
+
+    void Config::resolve(size_t slot)
+    {
+        if (_layers.empty()) {
+            return;
+        }
+        // both versions only increase, so their sum changes whenever either is modified
+        size_t version = _layerVersion + schemaVersion();
+        if (_resolvedVersion.size() < _table.size()) {
+            _resolvedVersion.resize(_table.size(), 0);
+        }
+        if (_resolvedVersion[slot] == version) {
+            return;
+        }
+        _resolvedVersion[slot] = version;
+        // hidden options (e.g. "help") are not configuration values
+        if (_table.hasOption(slot) && _table.option(slot).hidden()) {
+            _table.setValue(slot, false);
+            return;
+        }
+        const Value* value = layerValue(slot);
+        if (value) {
+            _table.value(slot) = *value;
+            mapChoice(slot, _table.value(slot));
+            _table.setValue(slot, true);
+        } else if (_table.hasOption(slot)) {
+            _table.value(slot) = _table.option(slot).defaultValue();
+            _table.setValue(slot, true);
+        } else {
+            _table.setValue(slot, false);
+        }
+    }
+
+    void Config::mapChoice(size_t slot, Value& value) const
+    {
+        if (value.type() == Value::DataType::STRING && _table.hasOption(slot) && 
+                _table.option(slot).type() == Value::DataType::CHOICE) {
+            value = _table.option(slot).choice(value.getStringRef());
+        }
+    }
+
+    const Value* Config::layerValue(size_t slot)
+    {
+        for (size_t i = _layers.size(); i-- > 0;) {
+            const Value* value = _layers[i].find(slot);
+            if (value) {
+                return value;
+            }
+        }
+        return nullptr;
+    }
+
+    void Config::resolveAll()
+    {
+        if (_layers.empty()) {
+            return;
+        }
+        for (size_t slot = 0; slot < _table.size(); ++slot) {
+            resolve(slot);
+        }
+    }
+
+    void Config::invalidate()
+    {
+        ++_layerVersion;
+    }
+
+    size_t Config::addLayer(const std::string& name)
+    {
+        _layers.push_back(ValueLayer(name));
+        invalidate();
+        return _layers.size() - 1;
+    }
+
+    size_t Config::findLayer(const std::string& name) const
+    {
+        for (size_t i = 0; i < _layers.size(); ++i) {
+            if (_layers[i].name() == name) {
+                return i;
+            }
+        }
+        return NO_SLOT;
+    }
+
+    size_t Config::layerCount() const
+    {
+        return _layers.size();
+    }
+
+    bool Config::loadLayer(size_t layer, const std::string& configPath)
+    {
+        if (layer >= _layers.size()) {
+            return false;
+        }
+        ValueLayer previous(_layers[layer]);
+        _layers[layer].clear();
+        _loadingLayer = layer;
+        bool loaded = loadFile(configPath);
+        _loadingLayer = NO_SLOT;
+        if (!loaded) {
+            _layers[layer] = std::move(previous);
+            return false;
+        }
+        invalidate();
+        return true;
+    }
+
+    void Config::setLayerValue(size_t layer, const std::string& flag, const Value& value)
+    {
+        if (layer < _layers.size()) {
+            size_t slot = _table.insert(flag);
+            Value& stored = _layers[layer].set(slot);
+            stored = value;
+            mapChoice(slot, stored);
+            invalidate();
+        }
+    }
+
+    void Config::clearLayer(size_t layer)
+    {
+        if (layer < _layers.size()) {
+            _layers[layer].clear();
+            invalidate();
+        }
+    }
+
+    // Handle
+    template <typename T>
+    Config::Handle<T>::Handle() : _slot(NO_SLOT)
+    {}
+
+    template <typename T>
+    Config::Handle<T>::Handle(size_t slot) : _slot(slot)
+    {}
+
+    template <typename T>
+    bool Config::Handle<T>::valid() const
+    {
+        return _slot != NO_SLOT;
+    }
+
+    template <typename T>
+    Config::Handle<T> Config::handle(const std::string& flag)
+    {
+        size_t slot = _table.insert(flag);
+        if (_table.hasOption(slot)) {
+            // a choice is read by its index or by its name
+            const Value::DataType type = _table.option(slot).type();
+            const bool choice = (type == Value::DataType::CHOICE) && 
+                (ValueTraits<T>::type() == Value::DataType::INT || ValueTraits<T>::type() == Value::DataType::STRING);
+            if (type != ValueTraits<T>::type() && !choice) {
+                log(LogLevel::ERROR, LogCode::HANDLE_TYPE_MISMATCH, flag);
+            }
+        }
+        return Handle<T>(slot);
+    }
+
+    template <typename T>
+    T Config::get(const Handle<T>& handle)
+    {
+        // an invalid handle, or a handle of a larger Config, has no slot in this table
+        if (handle._slot >= _table.size()) {
+            return ValueTraits<T>::get(Value());
+        }
+        // a removed value is reset to unknown, which reads as a default value
+        resolve(handle._slot);
+        return ValueTraits<T>::get(_table.value(handle._slot));
+    }
+
+#ifdef MINICONF_STATS_SUPPORT
+    const Config::ParseStats& Config::stats() const
+    {
+        return _stats;
+    }
+#endif
+
+    std::shared_ptr<const Config::Snapshot> Config::snapshot() const
+    {
+        return std::atomic_load(&_snapshot);
+    }
+
+    void Config::publish()
+    {
+        // a choice assigned by its name (e.g. by operator[]) is published as a choice
+        if (_layers.empty()) {
+            for (auto && slot : _table.values()) {
+                mapChoice(slot, _table.value(slot));
+            }
+        }
+        // the values of the layers are resolved by the snapshot when they are read
+        std::vector<std::shared_ptr<const ValueLayer::Values> > layers;
+        for (auto && layer : _layers) {
+            std::shared_ptr<const ValueLayer::Values> values = layer.share();
+#ifdef MINICONF_ARENA_SUPPORT
+            // values carved from the arena are copied to the heap, the snapshot may outlive the arena
+            if (_arena) {
+                values = std::make_shared<const ValueLayer::Values>(*values);
+            }
+#endif
+            layers.push_back(values);
+        }
+        size_t version = _snapshotVersion.load() + 1;
+        std::shared_ptr<const Snapshot> published(new Snapshot(_table, layers, version));
+        std::atomic_store(&_snapshot, published);
+        // bumped after the snapshot is stored, a cached handle seeing it finds the new snapshot
+        _snapshotVersion.store(version, std::memory_order_release);
     }
 
-    Value& Value::operator=(const char* other)
+    // CachedHandle
+    template <typename T>
+    Config::CachedHandle<T>::CachedHandle(const Config& config, const Handle<T>& handle) :
+        _config(&config),
+        _handle(handle),
+        _version(0),
+        _snapshot(),
+        _value()
     {
-        clearData();
-        return copyData(other, strlen(other) + 1, DataType::STRING);
+        refresh();
     }
 
-    Value::operator char*() const
+    template <typename T>
+    const T& Config::CachedHandle<T>::get()
     {
-        return reinterpret_cast<char*>(_data);
+        if (_config->_snapshotVersion.load(std::memory_order_relaxed) != _version) {
+            refresh();
+        }
+        return _value;
     }
 
-    char* Value::getCharArray() const
+    template <typename T>
+    Config::CachedHandle<T>::operator const T&()
     {
-        return reinterpret_cast<char*>(_data);
+        return get();
     }
 
-    //  std::string
-    Value::Value(const std::string& other) : Value()
+    template <typename T>
+    void Config::CachedHandle<T>::refresh()
     {
-        copyData(other.c_str(), other.size() + 1, DataType::STRING);
+        _snapshot = _config->snapshot();
+        if (_snapshot) {
+            _version = _snapshot->version();
+            _value = _snapshot->get(_handle);
+        }
     }
 
-    Value& Value::operator=(const std::string& other)
+    // Snapshot
+    Config::Snapshot::Snapshot(const FlatTable<Option>& table, const std::vector<std::shared_ptr<const ValueLayer::Values> >& layers, size_t version) : 
+        _table(table), 
+        _layers(layers),
+        _version(version),
+        _empty()
+    {}
+
+    const Value& Config::Snapshot::operator[](const std::string& flag) const
     {
-        clearData();
-        return copyData(other.c_str(), other.size() + 1, DataType::STRING);
+        return valueAt(slotOf(flag));
     }
 
-    Value::operator std::string() const
+    bool Config::Snapshot::contains(const std::string& flag) const
     {
-        return std::string(reinterpret_cast<char*>(_data));
+        return &valueAt(slotOf(flag)) != &_empty;
     }
 
-    std::string Value::getString() const
+    size_t Config::Snapshot::slotOf(const std::string& flag) const
     {
-        return std::string(reinterpret_cast<char*>(_data));
+        return _layers.empty() ? _table.findValue(flag) : _table.find(flag);
     }
 
-    // print function
-    std::string Value::print()
+    template <typename T>
+    T Config::Snapshot::get(const Handle<T>& handle) const
     {
-        const int slen = 31;
-        char tempStr[slen + 1];
-        std::string outStr;
-        switch (_type) {
-            case DataType::UNKNOWN:
-                snprintf(tempStr, slen, "null");
-                break;
-            case DataType::INT:
-                snprintf(tempStr, slen, "%d", getInt());
-                outStr = std::string(tempStr);
-                break;
-            case DataType::NUMBER:
-                snprintf(tempStr, slen, "%f", getNumber());
-                outStr = std::string(tempStr);
-                break;
-            case DataType::BOOL:
-                snprintf(tempStr, slen, "%s", getBoolean() ? "true" : "false");
-                outStr = std::string(tempStr);
-                break;
-            case DataType::STRING:
-                outStr = "\"" + std::string(getCharArray()) + "\"";
-                break;
-            default:
-                break;
-        }
-        return outStr;
+        return ValueTraits<T>::get(valueAt(handle._slot));
     }
 
-    // return data type
-    Value::DataType Value::type()
+    size_t Config::Snapshot::version() const
     {
-        return _type;
+        return _version;
     }
 
-    // check empty
-    bool Value::isEmpty()
+    const Value& Config::Snapshot::valueAt(size_t slot) const
     {
-        return (_data == nullptr || _type == DataType::UNKNOWN);
+        // only read-only lookups are used, the lazily sorted slot lists are never touched
+        if (slot >= _table.size()) {
+            return _empty;
+        }
+        if (_layers.empty()) {
+            return _table.hasValue(slot) ? _table.value(slot) : _empty;
+        }
+        // resolved like Config::resolve(), without caching the result
+        if (_table.hasOption(slot) && _table.option(slot).hidden()) {
+            return _empty;
+        }
+        for (size_t i = _layers.size(); i-- > 0;) {
+            const Value* value = ValueLayer::find(*_layers[i], slot);
+            if (value) {
+                return *value;
+            }
+        }
+        return _table.hasOption(slot) ? _table.option(slot).defaultValue() : _empty;
     }
 
-    // generate unknown value
-    Value Value::unknown()
+#ifdef MINICONF_SHM_SUPPORT
+    bool Config::publishShared(const std::string& name)
     {
-        return Value();
+        resolveAll();
+        std::string content;
+        Writer out(content);
+        writeBinary(out);
+
+        // the segment is written in place if it exists and the values fit
+        int fd = shm_open(name.c_str(), O_RDWR, 0);
+        if (fd < 0 && errno != ENOENT) {
+            log(LogLevel::ERROR, LogCode::SHARED_UNAVAILABLE, name, strerror(errno));
+            return false;
+        }
+        if (fd < 0) {
+            return createShared(name, content, 1);
+        }
+        struct stat st;
+        void* mapped = MAP_FAILED;
+        size_t mappedSize = 0;
+        if (fstat(fd, &st) == 0 && static_cast<size_t>(st.st_size) >= sizeof(SharedHeader)) {
+            mappedSize = static_cast<size_t>(st.st_size);
+            mapped = mmap(nullptr, mappedSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        }
+        close(fd);
+        if (mapped == MAP_FAILED) {
+            return createShared(name, content, 1);
+        }
+        SharedHeader* header = static_cast<SharedHeader*>(mapped);
+        uint64_t sequence = header->sequence.load(std::memory_order_relaxed);
+        uint64_t publication = sequence / 2 + 1;
+        bool fits = memcmp(header->magic, "MINISHM", 8) == 0 && sequence % 2 == 0
+            && header->capacity <= (mappedSize - sizeof(SharedHeader)) / 2
+            && content.size() <= header->capacity;
+        if (!fits) {
+            // readers of the old segment switch to the new one once it is retired
+            bool created = createShared(name, content, publication);
+            if (created) {
+                header->retired.store(1, std::memory_order_release);
+            }
+            munmap(mapped, mappedSize);
+            return created;
+        }
+
+        size_t buffer = publication % 2;
+        char* data = reinterpret_cast<char*>(header + 1) + buffer * header->capacity;
+        header->sequence.store(sequence + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        memcpy(data, content.data(), content.size());
+        header->sizes[buffer] = content.size();
+        header->sequence.store(sequence + 2, std::memory_order_release);
+        munmap(mapped, mappedSize);
+        log(LogLevel::INFO, LogCode::SHARED_PUBLISHED, name);
+        return true;
     }
 
-    // print value data type
-    std::string Value::printType()
+    bool Config::createShared(const std::string& name, const std::string& content, uint64_t publication)
     {
-        std::string outStr;
-        const int slen = 15;
-        char tempStr[slen + 1];
-        switch (_type) {
-            case DataType::UNKNOWN:
-                snprintf(tempStr, slen, "UNKNOWN");
-                break;
-            case DataType::INT:
-                snprintf(tempStr, slen, "INT");
-                break;
-            case DataType::NUMBER:
-                snprintf(tempStr, slen, "NUMBER");
-                break;
-            case DataType::BOOL:
-                snprintf(tempStr, slen, "BOOLEAN");
-                break;
-            case DataType::STRING:
-                snprintf(tempStr, slen, "STRING");
-                break;
-            default:
-                break;
+        // the buffers are doubled from the size of the values, so a growing config is rarely moved
+        uint64_t capacity = (content.size() * 2 + 7) / 8 * 8;
+        if (capacity < SHARED_MIN_CAPACITY) {
+            capacity = SHARED_MIN_CAPACITY;
         }
-        return std::string(tempStr);
+        size_t mappedSize = sizeof(SharedHeader) + 2 * capacity;
+
+        // the new segment replaces the old one by its name, readers of the old one keep their mapping
+        shm_unlink(name.c_str());
+        int fd = shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0644);
+        if (fd < 0) {
+            log(LogLevel::ERROR, LogCode::SHARED_UNAVAILABLE, name, strerror(errno));
+            return false;
+        }
+        void* mapped = MAP_FAILED;
+        if (ftruncate(fd, static_cast<off_t>(mappedSize)) == 0) {
+            mapped = mmap(nullptr, mappedSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        }
+        int error = errno;
+        close(fd);
+        if (mapped == MAP_FAILED) {
+            log(LogLevel::ERROR, LogCode::SHARED_UNAVAILABLE, name, strerror(error));
+            shm_unlink(name.c_str());
+            return false;
+        }
+
+        // the segment is zero-filled, so readers ignore it until the sequence is set
+        SharedHeader* header = static_cast<SharedHeader*>(mapped);
+        size_t buffer = publication % 2;
+        memcpy(header->magic, "MINISHM", 8);
+        header->capacity = capacity;
+        header->sizes[buffer] = content.size();
+        memcpy(reinterpret_cast<char*>(header + 1) + buffer * capacity, content.data(), content.size());
+        header->sequence.store(2 * publication, std::memory_order_release);
+        munmap(mapped, mappedSize);
+        log(LogLevel::INFO, LogCode::SHARED_PUBLISHED, name);
+        return true;
     }
 
-    // move and copy function
-    Value& Value::moveData(char*& src, const size_t size, const DataType type)
+    bool Config::unlinkShared(const std::string& name)
     {
-        _type = type;
-        _size = size;
-        _data = src;
-        src = nullptr;
-        return *this;
+        return shm_unlink(name.c_str()) == 0;
     }
 
-    // internal use
-    Value& Value::copyData(const char* src, const size_t size, const DataType& type)
+    // SharedSnapshot
+    Config::SharedSnapshot::SharedSnapshot(const std::string& name) :
+        _name(name),
+        _header(nullptr),
+        _mappedSize(0),
+        _sequence(0),
+        _content(),
+        _slots(nullptr),
+        _slotCount(0),
+        _strings(nullptr)
     {
-        char* newData = new char[size];
-        memcpy(newData, src, size);
-        return moveData(newData, size, type);
+        refresh();
     }
 
-    // internal use
-    void Value::clearData()
+    Config::SharedSnapshot::~SharedSnapshot()
     {
-        if (_size != 0 && _data != nullptr) {
-            delete _data;
-            _data = nullptr;
+        if (_header) {
+            munmap(const_cast<SharedHeader*>(_header), _mappedSize);
         }
     }
 
-    // Option
-    Config::Option::Option() : _flag(), _shortflag(), _description(), _defaultValue(Value::unknown()), _required(false), _hidden(false)
-    {}
+    bool Config::SharedSnapshot::good() const
+    {
+        return _sequence != 0;
+    }
 
-    Config::Option::~Option()
-    {}
+    bool Config::SharedSnapshot::refresh()
+    {
+        if (_header && !_header->retired.load(std::memory_order_acquire)) {
+            return read(_header);
+        }
+        // the segment has been replaced, or it has not been mapped yet
+        size_t mappedSize = 0;
+        const SharedHeader* header = map(_name, mappedSize);
+        if (!header) {
+            return false;
+        }
+        if (!read(header)) {
+            munmap(const_cast<SharedHeader*>(header), mappedSize);
+            return false;
+        }
+        if (_header) {
+            munmap(const_cast<SharedHeader*>(_header), _mappedSize);
+        }
+        _header = header;
+        _mappedSize = mappedSize;
+        return true;
+    }
 
-    Config::Option& Config::Option::flag(const std::string& flag)
+    bool Config::SharedSnapshot::valid() const
     {
-        _flag = flag;
-        return *this;
+        std::atomic_thread_fence(std::memory_order_acquire);
+        return good() && _header->sequence.load(std::memory_order_relaxed) < _sequence + 3;
     }
 
-    Config::Option& Config::Option::shortflag(const std::string& shortflag)
+    uint64_t Config::SharedSnapshot::version() const
     {
-        _shortflag = shortflag;
-        return *this;
+        return _sequence / 2;
     }
 
-    Config::Option& Config::Option::description(const std::string& description)
+    bool Config::SharedSnapshot::contains(const StringRef& flag) const
     {
-        _description = description;
-        return *this;
+        return find(flag) != nullptr;
     }
 
-    Config::Option& Config::Option::defaultValue(const Value& defaultValue)
+    Value::DataType Config::SharedSnapshot::type(const StringRef& flag) const
     {
-        _defaultValue = defaultValue;
-        return *this;
+        const BinarySlot* record = find(flag);
+        return record ? static_cast<Value::DataType>(record->type) : Value::DataType::UNKNOWN;
     }
 
-    Config::Option& Config::Option::defaultValue(const int& defaultValue)
+    int Config::SharedSnapshot::getInt(const StringRef& flag, int fallback) const
     {
-        _defaultValue = static_cast<int>(defaultValue);
-        return *this;
+        const BinarySlot* record = find(flag);
+        if (!record || record->type != static_cast<uint32_t>(Value::DataType::INT)) {
+            return fallback;
+        }
+        return static_cast<int>(static_cast<int64_t>(record->payload));
     }
 
-    Config::Option& Config::Option::defaultValue(const double& defaultValue)
+    double Config::SharedSnapshot::getNumber(const StringRef& flag, double fallback) const
     {
-        _defaultValue = static_cast<double>(defaultValue);
-        return *this;
+        const BinarySlot* record = find(flag);
+        if (!record || record->type != static_cast<uint32_t>(Value::DataType::NUMBER)) {
+            return fallback;
+        }
+        double number;
+        memcpy(&number, &record->payload, sizeof(double));
+        return number;
     }
 
-    Config::Option& Config::Option::defaultValue(const bool& defaultValue)
+    bool Config::SharedSnapshot::getBoolean(const StringRef& flag, bool fallback) const
     {
-        _defaultValue = static_cast<bool>(defaultValue);
-        return *this;
+        const BinarySlot* record = find(flag);
+        if (!record || record->type != static_cast<uint32_t>(Value::DataType::BOOL)) {
+            return fallback;
+        }
+        return record->payload != 0;
     }
 
-    Config::Option& Config::Option::defaultValue(const char* defaultValue)
+    StringRef Config::SharedSnapshot::getString(const StringRef& flag, const StringRef& fallback) const
     {
-        _defaultValue = defaultValue;
-        return *this;
+        const BinarySlot* record = find(flag);
+        if (!record || (record->type != static_cast<uint32_t>(Value::DataType::STRING) 
+                    && record->type != static_cast<uint32_t>(Value::DataType::CHOICE))) {
+            return fallback;
+        }
+        return StringRef(_strings + record->payload, record->length);
     }
 
-    Config::Option& Config::Option::defaultValue(const std::string& defaultValue)
+    ArrayRef<int> Config::SharedSnapshot::getIntArray(const StringRef& flag) const
     {
-        _defaultValue = static_cast<std::string>(defaultValue);
-        return *this;
+        const BinarySlot* record = find(flag);
+        if (!record || record->type != static_cast<uint32_t>(Value::DataType::INT_ARRAY)) {
+            return ArrayRef<int>();
+        }
+        return ArrayRef<int>(reinterpret_cast<const int*>(_strings + record->payload), record->length);
     }
 
-    Config::Option& Config::Option::required(const bool required)
+    ArrayRef<double> Config::SharedSnapshot::getNumberArray(const StringRef& flag) const
     {
-        _required = required;
-        return *this;
+        const BinarySlot* record = find(flag);
+        if (!record || record->type != static_cast<uint32_t>(Value::DataType::NUMBER_ARRAY)) {
+            return ArrayRef<double>();
+        }
+        return ArrayRef<double>(reinterpret_cast<const double*>(_strings + record->payload), record->length);
     }
 
-    Config::Option& Config::Option::hidden(const bool hidden)
+    ArrayRef<bool> Config::SharedSnapshot::getBooleanArray(const StringRef& flag) const
     {
-        _hidden = hidden;
-        return *this;
+        const BinarySlot* record = find(flag);
+        if (!record || record->type != static_cast<uint32_t>(Value::DataType::BOOL_ARRAY)) {
+            return ArrayRef<bool>();
+        }
+        return ArrayRef<bool>(reinterpret_cast<const bool*>(_strings + record->payload), record->length);
     }
 
-    std::string Config::Option::flag()
+    std::vector<StringRef> Config::SharedSnapshot::getStringArray(const StringRef& flag) const
     {
-        return _flag;
+        std::vector<StringRef> elements;
+        const BinarySlot* record = find(flag);
+        if (!record || record->type != static_cast<uint32_t>(Value::DataType::STRING_ARRAY)) {
+            return elements;
+        }
+        const uint32_t* pairs = reinterpret_cast<const uint32_t*>(_strings + record->payload);
+        elements.reserve(record->length);
+        for (uint32_t i = 0; i < record->length; ++i) {
+            elements.push_back(StringRef(_strings + pairs[2 * i], pairs[2 * i + 1]));
+        }
+        return elements;
     }
 
-    std::string Config::Option::shortflag()
+    bool Config::SharedSnapshot::load(Config& config) const
     {
-        return _shortflag;
+        if (!good()) {
+            return false;
+        }
+        bool loaded = config.deserialize(_content, ExportFormat::BINARY);
+        return valid() && loaded;
     }
 
-    std::string Config::Option::description()
+    const Config::SharedHeader* Config::SharedSnapshot::map(const std::string& name, size_t& mappedSize)
     {
-        return _description;
+        int fd = shm_open(name.c_str(), O_RDONLY, 0);
+        if (fd < 0) {
+            return nullptr;
+        }
+        struct stat st;
+        void* mapped = MAP_FAILED;
+        if (fstat(fd, &st) == 0 && static_cast<size_t>(st.st_size) >= sizeof(SharedHeader)) {
+            mappedSize = static_cast<size_t>(st.st_size);
+            mapped = mmap(nullptr, mappedSize, PROT_READ, MAP_SHARED, fd, 0);
+        }
+        close(fd);
+        if (mapped == MAP_FAILED) {
+            return nullptr;
+        }
+        // the header is complete once the sequence is set
+        const SharedHeader* header = static_cast<const SharedHeader*>(mapped);
+        if (header->sequence.load(std::memory_order_acquire) == 0 || memcmp(header->magic, "MINISHM", 8) != 0
+                || header->capacity % 8 != 0 || header->capacity > (mappedSize - sizeof(SharedHeader)) / 2) {
+            munmap(mapped, mappedSize);
+            return nullptr;
+        }
+        return header;
     }
 
-    Value Config::Option::defaultValue()
+    bool Config::SharedSnapshot::read(const SharedHeader* header)
     {
-        return _defaultValue;
+        // a publication being checked may be overwritten by a fast publisher, it is read again a few times
+        for (int attempt = 0; attempt < 4; ++attempt) {
+            uint64_t published = header->sequence.load(std::memory_order_acquire) & ~static_cast<uint64_t>(1);
+            if (published == 0 || (header == _header && published <= _sequence)) {
+                return false;
+            }
+            size_t buffer = (published / 2) % 2;
+            uint64_t size = header->sizes[buffer];
+            const char* data = reinterpret_cast<const char*>(header + 1) + buffer * header->capacity;
+            bool checked = size <= header->capacity && check(StringRef(data, size));
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (header->sequence.load(std::memory_order_relaxed) >= published + 3) {
+                continue;
+            }
+            if (!checked) {
+                return false;
+            }
+            BinaryHeader config;
+            memcpy(&config, data, sizeof(BinaryHeader));
+            _sequence = published;
+            _content = StringRef(data, size);
+            _slots = reinterpret_cast<const BinarySlot*>(data + sizeof(BinaryHeader));
+            _slotCount = config.slotCount;
+            _strings = data + sizeof(BinaryHeader) + config.slotCount * sizeof(BinarySlot);
+            return true;
+        }
+        return false;
     }
 
-    bool Config::Option::required()
+    bool Config::SharedSnapshot::check(const StringRef& content)
     {
-        return _required;
+        if (!isBinary(content)) {
+            return false;
+        }
+        BinaryHeader header;
+        memcpy(&header, content.data(), sizeof(BinaryHeader));
+        const uint64_t slotsSize = static_cast<uint64_t>(header.slotCount) * sizeof(BinarySlot);
+        if (header.version != BINARY_VERSION || header.byteOrder != BINARY_BYTE_ORDER
+                || sizeof(BinaryHeader) + slotsSize + header.stringsSize != content.size()) {
+            return false;
+        }
+        const BinarySlot* slots = reinterpret_cast<const BinarySlot*>(content.data() + sizeof(BinaryHeader));
+        const char* strings = content.data() + sizeof(BinaryHeader) + slotsSize;
+        StringRef previous;
+        for (uint32_t i = 0; i < header.slotCount; ++i) {
+            const BinarySlot& record = slots[i];
+            if (static_cast<uint64_t>(record.key) + record.keyLength > header.stringsSize 
+                    || !checkBinaryArray(strings, header, record)) {
+                return false;
+            }
+            StringRef key(strings + record.key, record.keyLength);
+            if (i > 0) {
+                int cmp = memcmp(previous.data(), key.data(), std::min(previous.size(), key.size()));
+                if (cmp > 0 || (cmp == 0 && previous.size() >= key.size())) {
+                    return false;
+                }
+            }
+            previous = key;
+            switch (static_cast<Value::DataType>(record.type)) {
+                case Value::DataType::STRING:
+                case Value::DataType::CHOICE:
+                    if (record.payload > header.stringsSize || record.length > header.stringsSize - record.payload) {
+                        return false;
+                    }
+                    break;
+                case Value::DataType::STRING_ARRAY: {
+                    const uint32_t* pairs = reinterpret_cast<const uint32_t*>(strings + record.payload);
+                    for (uint32_t j = 0; j < record.length; ++j) {
+                        if (static_cast<uint64_t>(pairs[2 * j]) + pairs[2 * j + 1] > header.stringsSize) {
+                            return false;
+                        }
+                    }
+                    break;
+                }
+                default:
+                    break;
+            }
+        }
+        return true;
     }
 
-    bool Config::Option::hidden()
+    const Config::BinarySlot* Config::SharedSnapshot::find(const StringRef& flag) const
     {
-        return _hidden;
+        // the records are sorted like the slots of a FlatTable, shorter keys first on a common prefix
+        size_t low = 0;
+        size_t high = _slotCount;
+        while (low < high) {
+            size_t mid = (low + high) / 2;
+            StringRef key(_strings + _slots[mid].key, _slots[mid].keyLength);
+            int cmp = memcmp(key.data(), flag.data(), std::min(key.size(), flag.size()));
+            if (cmp < 0 || (cmp == 0 && key.size() < flag.size())) {
+                low = mid + 1;
+            } else {
+                high = mid;
+            }
+        }
+        if (low < _slotCount && StringRef(_strings + _slots[low].key, _slots[low].keyLength) == flag) {
+            return &_slots[low];
+        }
+        return nullptr;
     }
+#endif
 
-    Value::DataType Config::Option::type()
+    void Config::print(FILE* fd)
     {
-        return _defaultValue.type();
+        resolveAll();
+        fprintf(fd, "\n[[[  %s  ]]]\n\n", "CONFIGURATION");
+
+        printf("|-------------------------|------------|--------------------------------------------------|\n");
+        printf("|           NAME          |    TYPE    |                     VALUE                        |\n");
+        printf("|-------------------------|------------|--------------------------------------------------|\n");
+        for (auto && slot : _table.values()) {
+            const char* flag = _table.key(slot).data();
+            const Value& v = _table.value(slot);
+            if (_table.hasOption(slot)) {
+                fprintf(fd, "| %-23s | %-10s | %-48s |\n", flag, v.printType().c_str(), v.print().c_str());
+            } else {
+                fprintf(fd, "| %-23s | %-10s | %-48s |\n", flag, (v.printType() + "*").c_str(), v.print().c_str());
+            }
+        }
+        printf("|-------------------------|------------|--------------------------------------------------|\n");
+        printf("\n");
     }
 
-    Config::Config() :
-        _verbose(false),
-        _logLevel(Config::LogLevel::WARNING),
-        _exeName(""),
-        _description(""),
-        _autoHelp(true),
-        _loadConfig(true)
+    std::string Config::serialize(const std::string& serializeFilePath, ExportFormat format, bool pretty)
     {
-        enableHelp(true); // set auto help to true
-        enableConfig(true); // set auto config to true
+        std::string outStr;
+
+        // extract extension
+        std::string extension = "";
+        size_t lastDot = serializeFilePath.find_last_of(".");
+        if (lastDot != std::string::npos) {
+            extension = serializeFilePath.substr(lastDot + 1);
+        }
+#ifdef MINICONF_JSON_SUPPORT
+        if (extension == "json" || extension == "JSON"){
+            format = ExportFormat::JSON; 
+        } else if (extension == "csv" || extension == "CSV"){
+            format = ExportFormat::CSV; 
+        } else if (extension == "bin" || extension == "BIN"){
+            format = ExportFormat::BINARY; 
+        }
+#else
+        if (extension == "bin" || extension == "BIN"){
+            format = ExportFormat::BINARY; 
+        } else if (extension == "csv" || extension == "CSV"){
+            format = ExportFormat::CSV; 
+        }
+#endif
+
+        Writer writer(outStr);
+        serializeTo(writer, format, pretty);
+
+        // write out file
+        if (!serializeFilePath.empty()) {
+            std::ofstream ofd(serializeFilePath, std::ios::out | std::ios::binary);
+            if (ofd.good()) {
+                ofd << outStr;
+                ofd.close();
+            }
+        }
+        return outStr;
     }
 
-    Config::~Config()
+    bool Config::serialize(FILE* fd, ExportFormat format, bool pretty)
     {
-        _options.clear();
-        _optionValues.clear();
-        _log.clear();
+        Writer writer(fd);
+        serializeTo(writer, format, pretty);
+        return writer.good();
     }
 
-    Config::Option& Config::option(const std::string& flag)
+    size_t Config::serialize(char* buffer, size_t size, ExportFormat format, bool pretty)
     {
-        _options.insert(std::make_pair(flag, Config::Option().flag(flag)));
-        return _options[flag];
+        Writer writer(buffer, size);
+        serializeTo(writer, format, pretty);
+        writer.terminate();
+        return writer.size();
     }
 
-    bool Config::remove(const std::string& flag)
+    void Config::serializeTo(Writer& out, ExportFormat format, bool pretty)
     {
-        if (findOption(flag)){
-            _options.erase(flag); 
-            return true; 
+        resolveAll();
+        switch (format) {
+#ifdef MINICONF_JSON_SUPPORT
+            case ExportFormat::JSON:
+                writeJSON(out, pretty);
+                break;
+#endif
+            case ExportFormat::CSV:
+                writeCSV(out);
+                break;
+            case ExportFormat::BINARY:
+                writeBinary(out);
+                break;
         }
-        return false; 
     }
 
-    void Config::setDefaultValues()
+#ifdef MINICONF_JSON_SUPPORT
+    void Config::writeJSON(Writer& out, bool pretty)
     {
-        for (auto && o : _options) {
-            _optionValues[o.first] = o.second.defaultValue();
+        // components of the currently open objects, and whether each level has a member
+        std::vector<StringRef> open;
+        std::vector<bool> hasMember(1, false);
+        std::vector<StringRef> parts;
+
+        // starts a member at the innermost level
+        auto beginMember = [&]() {
+            if (hasMember.back()) {
+                out.put(',');
+            }
+            hasMember.back() = true;
+            if (pretty) {
+                out.put('\n');
+                for (size_t i = 0; i < open.size() + 1; ++i) {
+                    out.write("  ", 2);
+                }
+            }
+        };
+        // closes the innermost level
+        auto endObject = [&]() {
+            if (pretty && hasMember.back()) {
+                out.put('\n');
+                for (size_t i = 0; i + 1 < hasMember.size(); ++i) {
+                    out.write("  ", 2);
+                }
+            }
+            out.put('}');
+            hasMember.pop_back();
+        };
+
+        out.put('{');
+        for (auto && slot : _table.values()) {
+            const Value& value = _table.value(slot);
+            if (value.isEmpty()) continue;
+
+            // split the dotted flag
+            StringRef key = _table.key(slot);
+            parts.clear();
+            const char* first = key.data();
+            const char* end = first + key.size();
+            for (const char* c = first; ; ++c) {
+                if (c == end || *c == '.') {
+                    parts.push_back(StringRef(first, static_cast<size_t>(c - first)));
+                    if (c == end) break;
+                    first = c + 1;
+                }
+            }
+
+            // close the objects which are not shared with the previous flag, then open new ones
+            size_t common = 0;
+            while (common < open.size() && common + 1 < parts.size() && open[common] == parts[common]) {
+                ++common;
+            }
+            while (open.size() > common) {
+                endObject();
+                open.pop_back();
+            }
+            for (size_t i = common; i + 1 < parts.size(); ++i) {
+                beginMember();
+                writeJSONString(out, parts[i]);
+                out.write(pretty ? ": {" : ":{", pretty ? 3 : 2);
+                open.push_back(parts[i]);
+                hasMember.push_back(false);
+            }
+            beginMember();
+            writeJSONString(out, parts.back());
+            out.write(": ", pretty ? 2 : 1);
+            writeJSONValue(out, value, pretty ? static_cast<int>(open.size()) + 1 : -1);
+        }
+        while (!open.empty()) {
+            endObject();
+            open.pop_back();
+        }
+        endObject();
+        if (pretty) {
+            out.put('\n');
         }
     }
 
-    void Config::log(const LogLevel logType)
+    void Config::writeJSONString(Writer& out, const StringRef& str)
     {
-        _logLevel = logType;
+        out.put('"');
+        const char* data = str.data();
+        const char* end = data + str.size();
+        const char* plain = data;
+        for (const char* c = data; c < end; ++c) {
+            const char* escaped = nullptr;
+            char code[7];
+            switch (*c) {
+                case '"': escaped = "\\\""; break;
+                case '\\': escaped = "\\\\"; break;
+                case '/': escaped = "\\/"; break;
+                case '\b': escaped = "\\b"; break;
+                case '\f': escaped = "\\f"; break;
+                case '\n': escaped = "\\n"; break;
+                case '\r': escaped = "\\r"; break;
+                case '\t': escaped = "\\t"; break;
+                default:
+                    if (static_cast<unsigned char>(*c) < 0x20 || *c == 0x7f) {
+                        snprintf(code, sizeof(code), "\\u%04x", *c & 0xff);
+                        escaped = code;
+                    }
+                    break;
+            }
+            if (escaped) {
+                // unescaped characters are written in runs
+                out.write(plain, static_cast<size_t>(c - plain));
+                out.write(StringRef(escaped));
+                plain = c + 1;
+            }
+        }
+        out.write(plain, static_cast<size_t>(end - plain));
+        out.put('"');
     }
 
-    void Config::log(FILE* fd)
+    void Config::writeJSONValue(Writer& out, const Value& value, int indent)
     {
-        fprintf(fd, "\n[[[  %s  ]]]\n\n", "PARSE LOG");
-        for (auto && logline : _log) {
-            fprintf(fd, "%s\n", logline.c_str());
+        if (value.isArray()) {
+            // same layout as picojson, one element per line
+            size_t size = value.arraySize();
+            ArrayRef<StringRef> strings = value.getStringArray();
+            out.put('[');
+            for (size_t i = 0; i < size; ++i) {
+                if (i > 0) {
+                    out.put(',');
+                }
+                if (indent >= 0) {
+                    out.put('\n');
+                    for (int j = 0; j < indent + 1; ++j) {
+                        out.write("  ", 2);
+                    }
+                }
+                switch (value.type()) {
+                    case Value::DataType::INT_ARRAY:
+                        writeJSONNumber(out, value.getIntArray()[i]);
+                        break;
+                    case Value::DataType::NUMBER_ARRAY:
+                        writeJSONNumber(out, value.getNumberArray()[i]);
+                        break;
+                    case Value::DataType::BOOL_ARRAY:
+                        out.write(StringRef(value.getBooleanArray()[i] ? "true" : "false"));
+                        break;
+                    default:
+                        writeJSONString(out, strings[i]);
+                        break;
+                }
+            }
+            if (indent >= 0 && size > 0) {
+                out.put('\n');
+                for (int j = 0; j < indent; ++j) {
+                    out.write("  ", 2);
+                }
+            }
+            out.put(']');
+            return;
+        }
+        switch (value.type()) {
+            case Value::DataType::INT:
+                writeJSONNumber(out, value.getInt());
+                return;
+            case Value::DataType::NUMBER:
+                writeJSONNumber(out, value.getNumber());
+                return;
+            case Value::DataType::BOOL:
+                out.write(StringRef(value.getBoolean() ? "true" : "false"));
+                return;
+            case Value::DataType::STRING:
+            case Value::DataType::CHOICE:
+                writeJSONString(out, value.getStringRef());
+                return;
+            default:
+                out.write("null", 4);
+                return;
         }
     }
 
-    void Config::log(Config::LogLevel logType, const std::string& token, const std::string& msg)
+    void Config::writeJSONNumber(Writer& out, double number)
     {
-        // do don't anything if log level is low
-        if (logType < _logLevel) {
+        if (!std::isfinite(number)) {
+            // json has no infinity or NaN
+            out.write("null", 4);
             return;
         }
-        const int tagWidth = 16;
-        char tag[tagWidth + 1];
-        char format[tagWidth + 1];
-        std::string logString = "";
-        snprintf(format, tagWidth, "<<<%%%ds>>>", tagWidth - 7);
-        switch (logType) {
-            case Config::LogLevel::INFO:
-                snprintf(tag, tagWidth, format, "INFO");
-                break;
-            case Config::LogLevel::WARNING:
-                snprintf(tag, tagWidth, format, "WARNING");
-                break;
-            case Config::LogLevel::ERROR:
-                snprintf(tag, tagWidth, format, "ERROR");
-                break;
-            default:
-                break;
-        }
-        logString = std::string(tag) + " Input \"" + token + "\" : " + msg;
-        _log.emplace_back(logString);
-        if (_verbose) {
-            fprintf(stdout, "%s\n", logString.c_str());
+        // same format as picojson, integers which are exact doubles have no decimals
+        char buffer[32];
+        double integral;
+        int length = snprintf(buffer, sizeof(buffer), (fabs(number) < 9007199254740992.0 && modf(number, &integral) == 0) ? "%.f" : "%.17g", number);
+        // printf uses the decimal point of the global locale, json always uses "."
+        const char* decimalPoint = localeconv()->decimal_point;
+        size_t pointLength = strlen(decimalPoint);
+        char* point = (pointLength > 0 && strcmp(decimalPoint, ".") != 0) ? strstr(buffer, decimalPoint) : nullptr;
+        if (point) {
+            *point = '.';
+            memmove(point + 1, point + pointLength, strlen(point + pointLength) + 1);
+            length -= static_cast<int>(pointLength - 1);
         }
+        out.write(buffer, static_cast<size_t>(length));
     }
+#endif
 
-    Config::TokenType Config::getTokenType(const char* token)
+    void Config::writeCSV(Writer& out)
     {
-        // get token type:
-        // starts with "--" - flag
-        // starts with "-" - shortflag/value
-        // otherwise value
-        size_t tlen = strlen(token);
-        if (tlen == 0) return TokenType::UNKNOWN;
-        if (token[0] == '-') {
-            // check if it can be converted to a number
-            char* endptr = nullptr;
-            std::strtod(token, &endptr);
-            if (*endptr == '\0' && endptr != token) {
-                return TokenType::VALUE;
+        for (auto && slot : _table.values()) {
+            const Value& value = _table.value(slot);
+            writeCSVField(out, _table.key(slot));
+            out.put(',');
+            if (value.type() == Value::DataType::STRING || value.type() == Value::DataType::CHOICE){
+                writeCSVField(out, value.getStringRef());
+            } else if (value.type() == Value::DataType::STRING_ARRAY){
+                ArrayRef<StringRef> elements = value.getStringArray();
+                for (size_t i = 0; i < elements.size(); ++i){
+                    if (i > 0) out.put(',');
+                    writeCSVField(out, elements[i]);
+                }
+            } else if (value.isArray()){
+                for (size_t i = 0; i < value.arraySize(); ++i){
+                    if (i > 0) out.put(',');
+                    out.write(value.element(i).print());
+                }
+            } else {
+                out.write(value.print());
             }
-            return (token[1] == '-') ? TokenType::FLAG : TokenType::SHORTFLAG;
+            out.put('\n');
         }
-        return TokenType::VALUE;
     }
 
-    std::string Config::translateShortflag(const std::string& shortflag)
+    void Config::config(const std::string& configPath)
     {
-        auto found = _options.begin();
-        auto end = _options.end();
-        for (; found != end; ++found) {
-            if (found->second.shortflag() == shortflag) {
-                break;
+        _configPath = configPath;
+        loadFile(configPath);
+    }
+
+    size_t Config::configFiles(const std::vector<std::string>& configPaths, size_t threads)
+    {
+#ifdef MINICONF_THREAD_SUPPORT
+        if (threads == 0) {
+            threads = std::thread::hardware_concurrency();
+        }
+        threads = std::min(threads, configPaths.size());
+#else
+        threads = 1;
+#endif
+        if (threads <= 1) {
+            // without concurrency the files are loaded directly, skipping the staging buffers
+            size_t loaded = 0;
+            for (auto && configPath : configPaths) {
+                loaded += loadFile(configPath) ? 1 : 0;
             }
+            if (!configPaths.empty()) {
+                _configPath = configPaths.back();
+            }
+            return loaded;
+        }
+        MINICONF_STATS(StopWatch watch;)
+
+        // the table is only read while loading, so its lazily sorted slots are built first
+        _table.options();
+        std::vector<Staging> stagings(configPaths.size());
+#ifdef MINICONF_THREAD_SUPPORT
+        std::atomic<size_t> next(0);
+        auto worker = [&]() {
+            for (size_t i = next++; i < configPaths.size(); i = next++) {
+                stageFile(configPaths[i], stagings[i]);
+            }
+        };
+        std::vector<std::thread> pool;
+        for (size_t i = 1; i < threads; ++i) {
+            pool.emplace_back(worker);
+        }
+        worker();
+        for (auto && thread : pool) {
+            thread.join();
         }
-        if (found != end) {
-            return found->first;
+#endif
+
+        // merge in the order of the files, so later files take precedence
+        size_t loaded = 0;
+        for (auto && stage : stagings) {
+            commitStage(stage);
+            loaded += stage.loaded ? 1 : 0;
         }
-        return shortflag;
+        _configPath = configPaths.back();
+        MINICONF_STATS(
+            _stats.fileLoadTime += watch.lap();
+            _stats.configFiles += configPaths.size();
+        )
+        return loaded;
     }
 
-    bool Config::findOption(const std::string& flag)
+    Config::Staging*& Config::staging()
     {
-        return (_options.find(flag) != _options.end());
+        static thread_local Staging* current = nullptr;
+        return current;
     }
 
-    Config::Option* Config::getOption(const char* token, Config::TokenType tokenType)
+    void Config::stageFile(const std::string& configPath, Staging& stage)
     {
-        std::string flag = "";
-        if (tokenType == TokenType::FLAG) {
-            flag = std::string(token + 2);
-        } else if (tokenType == TokenType::SHORTFLAG) {
-            flag = translateShortflag(std::string(token + 1));
-        }
-        if (flag.empty()) {
-            return nullptr;
-        }
-        if (findOption(flag)) {
-            return &(_options[flag]);
+        staging() = &stage;
+        FileBuffer file(configPath);
+        if (file.good()) {
+            stage.loaded = loadContent(configPath, file.content());
+        } else {
+            log(LogLevel::ERROR, LogCode::CONFIG_UNREADABLE, configPath);
+            stage.loaded = false;
         }
-        return nullptr;
+        staging() = nullptr;
     }
 
-    Value Config::parseValue(const char* token, Value::DataType dataType)
+    void Config::commitStage(Staging& stage)
     {
-        if (dataType == Value::DataType::INT) {
-            int v;
-            int success = sscanf(token, "%d", &v);
-            return (success == 1) ? Value(v) : Value::unknown();
+        for (auto && value : stage.values) {
+            valueAt(value.first) = std::move(value.second);
         }
-        if (dataType == Value::DataType::NUMBER) {
-            double v;
-            int success = sscanf(token, "%lf", &v);
-            return (success == 1) ? Value(v) : Value();
-
+        for (auto && stray : stage.strays) {
+            valueOf(stray.first) = std::move(stray.second);
         }
-        if (dataType == Value::DataType::BOOL) {
-            std::string v(token);
-            if (v == "false" || v == "False" || v == "FALSE" || v == "F" || v == "f") {
-                return Value(false);
-            }
-            return Value(true);
+        replayLog(stage);
+    }
 
+    void Config::replayLog(const Staging& stage)
+    {
+        for (auto && entry : stage.log) {
+            record(entry.level, entry.code,
+                StringRef(stage.logText.data() + entry.token, entry.tokenLength),
+                StringRef(stage.logText.data() + entry.detail, entry.detailLength));
         }
-        if (dataType == Value::DataType::STRING) {
-            return Value(token);
-        }
-        return Value::unknown(); // fool-proof, return an unknown
     }
 
-    static Config::LogLevel worseLevel(const Config::LogLevel& a, const Config::LogLevel& b)
+    bool Config::loadFile(const std::string& configPath)
     {
-        return ((a) < (b)) ? (b) : (a);
+        ArenaScope scope(*this);
+        MINICONF_STATS(StopWatch watch;)
+
+        // map (or read) content of the file, the parsers read the buffer directly
+        FileBuffer file(configPath);
+        MINICONF_STATS(_stats.fileReadTime += watch.lap();)
+        if (!file.good()) {
+            log(LogLevel::ERROR, LogCode::CONFIG_UNREADABLE, configPath);
+            return false;
+        }
+        bool loaded = loadContent(configPath, file.content());
+        MINICONF_STATS(
+            _stats.fileLoadTime += watch.lap();
+            ++_stats.configFiles;
+        )
+        return loaded;
     }
 
-    Config::LogLevel Config::checkFormat()
+    bool Config::deserialize(const StringRef& content, ExportFormat format)
     {
-        LogLevel errorLv = LogLevel::INFO;
-        for (auto && opt : _options) {
-            Option& o = opt.second;
-            // check for error
-            if (!o.required() && o.defaultValue().isEmpty()) {
-                log(LogLevel::ERROR, o.flag(), "default value is not defined");
-                errorLv = worseLevel(errorLv, LogLevel::ERROR);
-            }
-            for (auto& opt2 : _options) {
-                Option& o2 = opt2.second;
-                if ((o.flag() != o2.flag()) && (o.shortflag() == o2.shortflag()) && !(o.shortflag().empty())) {
-                    log(LogLevel::ERROR, o.flag(), "duplicate short flags (" + o2.shortflag() + ")");
-                    errorLv = worseLevel(errorLv, LogLevel::ERROR);
-                }
-            }
-            // check for warnings
-            if (o.description().empty()) {
-                log(LogLevel::WARNING, o.flag(), "no description text for argument");
-                errorLv = worseLevel(errorLv, LogLevel::WARNING);
-            }
-            if (o.shortflag().empty()) {
-                log(LogLevel::WARNING, o.flag(), "no short flag is provided");
-                errorLv = worseLevel(errorLv, LogLevel::WARNING);
-            }
+        ArenaScope scope(*this);
+        if (format == ExportFormat::BINARY || isBinary(content)) {
+            return loadBinary(content);
         }
-        if (_description.empty()) {
-            log(LogLevel::WARNING, "", "No program description text is provided");
-            errorLv = worseLevel(errorLv, LogLevel::WARNING);
+#ifdef MINICONF_JSON_SUPPORT
+        if (format == ExportFormat::JSON) {
+            return loadJSON(content);
         }
-        return errorLv;
+#endif
+        return loadCSV(content);
     }
 
-    // Validate User Input
-    Config::LogLevel Config::validate()
+    bool Config::loadContent(const std::string& configPath, const StringRef& configContent)
     {
-        LogLevel errorLv = LogLevel::INFO;
-
-        // remove all the hidden values
-        for (auto&& opt: _options){
-            if (opt.second.hidden() && contains(opt.first)){
-                _optionValues.erase(opt.first);
-            }
+        // extract extension
+        std::string extension = "";
+        size_t lastDot = configPath.find_last_of(".");
+        if (lastDot != std::string::npos) {
+            extension = configPath.substr(lastDot + 1);
         }
 
-        // scan for all option vlaues 
-        for (auto && val : _optionValues) {
-            if (val.second.isEmpty()) {
-                log(LogLevel::ERROR, val.first, "option contains invalid value");
-                errorLv = worseLevel(errorLv, LogLevel::ERROR);
+        // load config according to its header or extension
+        // default is json
+        bool loaded = false;
+        if (isBinary(configContent)) {
+            loaded = loadBinary(configContent);
+        } else {
+#ifdef MINICONF_JSON_SUPPORT
+            if (extension == "csv" || extension == "CSV") {
+                loaded = loadCSV(configContent);
+            } else {
+                loaded = loadJSON(configContent);
             }
+#else
+            loaded = loadCSV(configContent);
+#endif
         }
+        return loaded;
+    }
 
-        // scan for all remaining options are defined
-        for (auto && opt : _options) {
-            if (!contains(opt.first) && !opt.second.hidden()) {
-                log(LogLevel::ERROR, opt.first, "option is undefined");
-                errorLv = worseLevel(errorLv, LogLevel::ERROR);
-            }
-        }
-        return errorLv;
+    size_t Config::environment(const std::string& prefix)
+    {
+        return loadEnvironment(MINICONF_ENVIRON, prefix);
     }
 
-    bool Config::parse(int argc, char **argv)
+    size_t Config::loadEnvironmentLayer(size_t layer, const std::string& prefix)
     {
-        // Extract executable name
-        _exeName = std::string(argv[0]);
-        size_t lastslash = _exeName.find_last_of("\\/");
-        if (lastslash != std::string::npos) {
-            _exeName = _exeName.substr(lastslash + 1);
+        if (layer >= _layers.size()) {
+            return 0;
         }
+        _layers[layer].clear();
+        _loadingLayer = layer;
+        size_t loaded = loadEnvironment(MINICONF_ENVIRON, prefix);
+        _loadingLayer = NO_SLOT;
+        invalidate();
+        return loaded;
+    }
 
-        // check format of the option parser
-        // if fatal error occurs and log level is not "NONE" (NONE = ignore errors)
-        LogLevel checkFormatResult = checkFormat();
-        if (checkFormatResult >= LogLevel::ERROR && _logLevel <= LogLevel::ERROR) {
-            log();
-            printf("\nFatal Error: Option format validation failed, abort.\n\n");
-            return false;
+    size_t Config::loadEnvironment(const char* const* entries, const std::string& prefix)
+    {
+        ArenaScope scope(*this);
+        // index the variable names of the options, so each variable is looked up once
+        const std::vector<size_t>& slots = _table.options();
+        std::vector<std::string> names;
+        names.reserve(slots.size());
+        for (auto && slot : slots) {
+            names.push_back(environmentName(prefix, _table.key(slot)));
         }
-
-        // define a wildcard option to capture "stray" option values (values without a flag)
-        // string argument by default
-        Config::Option wildcard;
-        wildcard.defaultValue("");
-
-        // Value Precedence:
-        // (1) Default Value
-        // (2) Config File Settings (overwrites default values)
-        // (3) Command Line Arguments (overwrites default values and config file)
-
-        // * Set Default Values
-        setDefaultValues();
-
-        // * Load Config File before scanning for other arguments
-        // case 1: only config file is defined, flag is not necessary
-        // case 2: check if config flag has been defined
-        if (_loadConfig) {
-            for (int i = 1; i < argc - 1; ++i) {
-                std::string flag = std::string(argv[i]);
-                std::string value = std::string(argv[i + 1]);
-                TokenType ttype = getTokenType(argv[i + 1]);
-                if (( flag == "--config" || flag == "-cfg" ) && (ttype == TokenType::VALUE)) {
-                    config(value);
-                }
+        auto keyOf = [&names](size_t i) { return StringRef(names[i]); };
+        FlagIndex index;
+        index.reset(names.size());
+        for (size_t i = 0; i < names.size(); ++i) {
+            // hidden options are not loaded, they do not take the name of another option
+            if (_table.option(slots[i]).hidden()) {
+                continue;
+            }
+            // e.g. "a.b" and "a__b", or "numOpt" and "numopt", the first option keeps the name
+            size_t other = index.insert(names[i], i, keyOf);
+            if (other != NO_SLOT) {
+                log(LogLevel::WARNING, LogCode::ENVIRONMENT_NAME_COLLISION, _table.key(slots[i]), _table.key(slots[other]));
             }
         }
 
-        // start normal parsing
-        Option* currentOption = nullptr;
-        for (int i = 1; i < argc; ++i) {
-            TokenType currentTokenType = getTokenType(argv[i]);
-            if (currentTokenType == TokenType::UNKNOWN) {
-                log(LogLevel::ERROR, std::string(argv[i]), "unknown input");
-            } else if (currentTokenType == TokenType::FLAG || currentTokenType == TokenType::SHORTFLAG) {
-                currentOption = getOption(argv[i], currentTokenType);
-                if (!currentOption) {
-                    log(LogLevel::WARNING, std::string(argv[i]), "unrecognized flag");
-                    if (currentTokenType == TokenType::FLAG) {
-                        wildcard.flag(std::string(argv[i] + 2));
-                        currentOption = &wildcard;
-                    }
-                }
-                // special case - if the option type is bool, set to true by default
-                if (currentOption && currentOption->type() == Value::DataType::BOOL) {
-                    _optionValues[currentOption->flag()] = true;
-                }
-            } else if (currentTokenType == TokenType::VALUE) {
-                if (currentOption) {
-                    // parse the value according to default data type
-                    Value newValue = parseValue(argv[i], currentOption->type());
-                    // if value cannot be parsed
-                    if (newValue.isEmpty()) {
-                        log(LogLevel::WARNING, std::string(argv[i]), "unvalid value type is provided");
-                    } else {
-                        // assign parsed values
-                        _optionValues[currentOption->flag()] = parseValue(argv[i], currentOption->type());
-                        log(LogLevel::INFO, std::string(argv[i]), "value parsed successfully");
-                    }
-                    // reset current option flag -> ready for a new flag
-                    currentOption = nullptr;
-                } else {
-                    // stray arguments, ignore
-                    log(LogLevel::WARNING, std::string(argv[i]), "unassociated argument is not stored");
+        size_t loaded = 0;
+        std::vector<StringRef> elements;
+        for (const char* const* entry = entries; entry && *entry; ++entry) {
+            if (strncmp(*entry, prefix.c_str(), prefix.size()) != 0) {
+                continue;
+            }
+            const char* separator = strchr(*entry, '=');
+            if (!separator) {
+                continue;
+            }
+            StringRef name(*entry, separator - *entry);
+            size_t i = index.find(name, keyOf);
+            if (i == NO_SLOT) {
+                continue;
+            }
+            size_t slot = slots[i];
+            Value::DataType type = _table.option(slot).type();
+            StringRef text(separator + 1);
+            Value value;
+            if (Value::elementType(type) != Value::DataType::UNKNOWN) {
+                elements.clear();
+                for (const char* first = text.data(), *last = text.data() + text.size(); first != last;) {
+                    const char* comma = std::find(first, last, ',');
+                    elements.push_back(StringRef(first, comma - first));
+                    first = (comma == last) ? last : comma + 1;
                 }
+                value = parseArray(elements, type);
+            } else {
+                value = (type == Value::DataType::CHOICE) ? _table.option(slot).choice(text) : parseValue(text, type);
+            }
+            if (value.isEmpty()) {
+                log(LogLevel::WARNING, LogCode::ENVIRONMENT_VALUE_INVALID, name);
+                continue;
             }
+            valueAt(slot) = std::move(value);
+            log(LogLevel::INFO, LogCode::ENVIRONMENT_VALUE_LOADED, _table.key(slot));
+            ++loaded;
         }
+        return loaded;
+    }
 
-        // if contains help and auto-help is enabled, display help message
-        if (contains("help") && _optionValues["help"].getBoolean() && _autoHelp) {
-            help();
+    std::string Config::environmentName(const std::string& prefix, const StringRef& flag)
+    {
+        std::string name = prefix;
+        for (size_t i = 0; i < flag.size(); ++i) {
+            unsigned char c = static_cast<unsigned char>(flag.data()[i]);
+            if (c == '.') {
+                name += "__";
+            } else if (isalnum(c)) {
+                name += static_cast<char>(toupper(c));
+            } else {
+                name += '_';
+            }
         }
+        return name;
+    }
 
-        // validate user inputs
-        // remove all hidden options
-        // reserved words should not be displayed as normal config values
-
-        // if fatal error occurs and log level is not "NONE" (NONE = ignore errors)
-        LogLevel validateResult = validate();
-        if (validateResult >= LogLevel::ERROR && _logLevel <= LogLevel::ERROR) {
-            log();
-            printf("\nFatal Error: Option format validation failed, abort.\n\n");
-            return false;
-        }
+#ifdef MINICONF_ARENA_SUPPORT
+    void Config::arena(size_t blockSize)
+    {
+        _arenaBlockSize = blockSize;
+        moveArena(blockSize > 0 ? std::make_shared<Arena>(blockSize) : std::shared_ptr<Arena>());
+    }
 
-        return true;
+    size_t Config::arenaSize() const
+    {
+        return _arena ? _arena->used() : 0;
     }
 
-    void Config::help(FILE* fd)
+    void Config::moveArena(const std::shared_ptr<Arena>& arena)
     {
-        // print program description
-        if (!_description.empty()) {
-            fprintf(fd, "\n");
-            if (!_exeName.empty()) {
-                fprintf(fd, "[[[  %s  ]]]\n\n    ", _exeName.c_str());
-            }
-            fprintf(fd, "%s\n\n", _description.c_str());
+        // the copies are allocated from the new arena, then the old buffers are dropped with it
+        Arena* previous = Arena::activate(arena.get());
+        for (auto && slot : _table.values()) {
+            _table.value(slot) = Value(_table.value(slot));
         }
+        for (auto && layer : _layers) {
+            layer.copyValues();
+        }
+        Arena::activate(previous);
+        _arena = arena;
+        _arenaLive = arena ? arena->used() : 0;
+    }
 
-        // print usage
-        usage();
-        // print help
-        fprintf(fd, "\n[[[  %s  ]]]\n\n", "HELP");
-        for (auto && opt : _options) {
-            Option& o = opt.second;
-            // print short
-            fprintf(fd, "    ");
-            if (!o.shortflag().empty()) {
-                fprintf(fd, "-%s, ", o.shortflag().c_str());
-            }
-            // print long
-            fprintf(fd, "--%s ", o.flag().c_str());
-            // required
-            if (o.required()) {
-                fprintf(fd, "<REQUIRED>");
-            }
-            fprintf(fd, "\n");
-            // print description
-            fprintf(fd, "        ");
-            if (!o.description().empty()) {
-                fprintf(fd, "%s ", o.description().c_str());
-            }
-            // default value
-            if (!o.defaultValue().isEmpty() && !o.hidden()) {
-                fprintf(fd, " ( ");
-                fprintf(fd, "DEFAULT = %s", o.defaultValue().print().c_str());
-                fprintf(fd, " ) ");
-            }
-            fprintf(fd, "\n\n");
+    void Config::compactArena()
+    {
+        if (_arena && _arena->used() > 2 * _arenaLive + _arenaBlockSize) {
+            moveArena(std::make_shared<Arena>(_arenaBlockSize));
         }
     }
 
-    void Config::usage(FILE* fd)
+    // ArenaScope
+    Config::ArenaScope::ArenaScope(Config& config) : _config(config), _previous(nullptr)
     {
-        fprintf(fd, "\n[[[  %s  ]]]\n\n", "USAGE");
-        char exeTag[256];
-        snprintf(exeTag, 256 - 1, "    %s ", (_exeName.empty()) ? ("<executable>") : (_exeName.c_str()));
-        fprintf(fd, "%s", exeTag);
-        int lineWidth = 0;
-        for (auto && opt : _options) {
-            Option& o = opt.second;
-            char argTag[512];
-            snprintf(argTag, 512 - 1, "%s%s%s <%s>%s",
-                    o.required() ? "" : "[",
-                    o.shortflag().empty() ? "--" : "-",
-                    o.shortflag().empty() ? o.flag().c_str() : o.shortflag().c_str(),
-                    o.defaultValue().printType().c_str(),
-                    o.required() ? "" : "]");
-            if (lineWidth + strlen(argTag) >= 80 - 1 - strlen(exeTag)) {
-                fprintf(fd, "\n%*s", static_cast<int>(strlen(exeTag)), " ");
-                lineWidth = 0;
+        if (_config._arenaDepth++ == 0 && _config._arena) {
+            // a copied Config shares the arena, each Config allocates from its own
+            if (_config._arena.use_count() > 1) {
+                _config.moveArena(std::make_shared<Arena>(_config._arenaBlockSize));
             }
-            fprintf(fd, "%s ", argTag);
-            lineWidth += strlen(argTag);
+            _previous = Arena::activate(_config._arena.get());
         }
-        fprintf(fd, "\n\n");
     }
 
-    void Config::description(const std::string& desc)
+    Config::ArenaScope::~ArenaScope()
     {
-        _description = desc;
+        if (--_config._arenaDepth == 0 && _config._arena) {
+            Arena::activate(_previous);
+            _config.compactArena();
+        }
     }
+#else
+    // ArenaScope
+    Config::ArenaScope::ArenaScope(Config&)
+    {}
 
-    void Config::enableConfig(bool enabled)
+    Config::ArenaScope::~ArenaScope()
+    {}
+#endif
+
+    bool Config::reload()
     {
-        _loadConfig = enabled;
-        if (_autoHelp && !findOption("config")) {
-            option("config").
-                shortflag("cfg").
-                defaultValue("").
-                description("Input configuration file (JSON/CSV)").
-                required(false).hidden(true);
-        } else {
-            if (findOption("config")) {
-                _options.erase("config");
+        if (_configPath.empty()) {
+            log(LogLevel::WARNING, LogCode::NOTHING_TO_RELOAD, "");
+            return false;
+        }
+
+        {
+            // the file is loaded into a staging buffer, the current values are untouched if it fails
+            ArenaScope scope(*this);
+            _table.options();
+            Staging stage;
+            stageFile(_configPath, stage);
+            replayLog(stage);
+            if (!stage.loaded) {
+                log(LogLevel::ERROR, LogCode::RELOAD_FAILED, _configPath);
+                return false;
             }
-        }
 
+            // only the flags of the file are compared, the last value of a repeated flag is applied
+            std::stable_sort(stage.values.begin(), stage.values.end(),
+                [](const std::pair<size_t, Value>& a, const std::pair<size_t, Value>& b) { return a.first < b.first; });
+            for (size_t i = 0; i < stage.values.size(); ++i) {
+                if (i + 1 < stage.values.size() && stage.values[i + 1].first == stage.values[i].first) {
+                    continue;
+                }
+                applyReloaded(stage.values[i].first, std::move(stage.values[i].second));
+            }
+            for (auto && stray : stage.strays) {
+                applyReloaded(_table.insert(stray.first), std::move(stray.second));
+            }
+        }
+        publish();
+        return true;
     }
 
-    void Config::enableHelp(bool enabled)
+    void Config::applyReloaded(size_t slot, Value&& value)
     {
-        _autoHelp = enabled;
-        if (_autoHelp && !findOption("help")) {
-            option("help").
-                shortflag("h").
-                defaultValue(false).
-                description("Display the help message").
-                required(false).hidden(true);
-        } else {
-            if (findOption("help")) {
-                _options.erase("help");
-            }
+        // the value is replaced in place, so references to it stay valid
+        resolve(slot);
+        const bool existed = _table.hasValue(slot);
+        Value& current = valueAt(slot);
+        if (existed && current == value) {
+            return;
         }
+        Value previous(existed ? std::move(current) : Value());
+        current = std::move(value);
+        log(LogLevel::INFO, LogCode::VALUE_RELOADED, _table.key(slot));
+        notifyChange(_table.key(slot).str(), previous, current);
     }
 
-    void Config::verbose(bool value)
+    void Config::onChange(const std::string& pattern, const ChangeCallback& callback)
     {
-        _verbose = value;
+        _changeCallbacks.push_back(std::make_pair(pattern, callback));
     }
 
-    bool Config::contains(const std::string& flag)
+    void Config::notifyChange(const std::string& flag, const Value& previous, const Value& current)
     {
-        return _optionValues.find(flag) != _optionValues.end();
+        for (auto && entry : _changeCallbacks) {
+            const std::string& pattern = entry.first;
+            bool matched = false;
+            if (!pattern.empty() && pattern[pattern.size() - 1] == '*') {
+                // prefix pattern, e.g. "part2.subpart1.*"
+                matched = flag.compare(0, pattern.size() - 1, pattern, 0, pattern.size() - 1) == 0;
+            } else {
+                matched = (flag == pattern);
+            }
+            if (matched) {
+                entry.second(flag, previous, current);
+            }
+        }
     }
 
-    Value& Config::operator[](const std::string& flag)
+    StringRef Config::readCSVField(const char*& pos, const char* end, std::string& buffer, bool& endOfRecord)
     {
-        return _optionValues[flag];
+        endOfRecord = false;
+        StringRef field;
+        if (pos < end && *pos == '"') {
+            // quoted field, may contain commas, line breaks and escaped quotes ("")
+            buffer.clear();
+            ++pos;
+            while (pos < end) {
+                const char* quote = static_cast<const char*>(memchr(pos, '"', end - pos));
+                quote = quote ? quote : end;
+                buffer.append(pos, quote);
+                pos = quote + 1;
+                if (pos < end && *pos == '"') {
+                    buffer.push_back('"');
+                    ++pos;
+                } else {
+                    break;
+                }
+            }
+            field = StringRef(buffer);
+            // skip anything between the closing quote and the delimiter
+            while (pos < end && *pos != ',' && *pos != '\n') {
+                ++pos;
+            }
+        } else {
+            // unquoted field, refers to the input buffer directly
+            const char* start = pos;
+            while (pos < end && *pos != ',' && *pos != '\n') {
+                ++pos;
+            }
+            const char* last = pos;
+            if (last > start && *(last - 1) == '\r' && (pos == end || *pos == '\n')) {
+                --last;
+            }
+            field = StringRef(start, last - start);
+        }
+        if (pos >= end || *pos == '\n') {
+            endOfRecord = true;
+        }
+        if (pos < end) {
+            ++pos;
+        }
+        return field;
     }
 
-    void Config::print(FILE* fd)
+    void Config::writeCSVField(Writer& out, const StringRef& field)
     {
-        fprintf(fd, "\n[[[  %s  ]]]\n\n", "CONFIGURATION");
-
-        printf("|-------------------------|------------|--------------------------------------------------|\n");
-        printf("|           NAME          |    TYPE    |                     VALUE                        |\n");
-        printf("|-------------------------|------------|--------------------------------------------------|\n");
-        for (auto && v : _optionValues) {
-            if (_options.find(v.first.c_str()) != _options.end()) {
-                fprintf(fd, "| %-23s | %-10s | %-48s |\n", v.first.c_str(), v.second.printType().c_str(), v.second.print().c_str());
-            } else {
-                fprintf(fd, "| %-23s | %-10s | %-48s |\n", v.first.c_str(), (v.second.printType() + "*").c_str(), v.second.print().c_str());
+        const char* data = field.data();
+        const char* end = data + field.size();
+        bool quoted = false;
+        for (const char* c = data; c < end && !quoted; ++c) {
+            quoted = (*c == ',' || *c == '"' || *c == '\n' || *c == '\r');
+        }
+        if (!quoted) {
+            out.write(field);
+            return;
+        }
+        out.put('"');
+        for (const char* c = data; c < end; ++c) {
+            if (*c == '"') {
+                out.put('"');
             }
+            out.put(*c);
         }
-        printf("|-------------------------|------------|--------------------------------------------------|\n");
-        printf("\n");
+        out.put('"');
     }
 
-    std::string Config::serialize(const std::string& serializeFilePath, ExportFormat format, bool pretty)
+    bool Config::isBinary(const StringRef& content)
     {
-        std::stringstream ss;
-        std::string outStr;
+        return content.size() >= sizeof(BinaryHeader) && memcmp(content.data(), "MINICONF", 8) == 0;
+    }
 
-        // extract extension
-        std::string extension = "";
-        size_t lastDot = serializeFilePath.find_last_of(".");
-        if (lastDot != std::string::npos) {
-            extension = serializeFilePath.substr(lastDot + 1);
+    bool Config::loadBinary(const StringRef& content)
+    {
+        if (!isBinary(content)) {
+            log(LogLevel::ERROR, LogCode::BINARY_CORRUPTED, "");
+            return false;
         }
-#ifdef MINICONF_JSON_SUPPORT
-        if (extension == "json" || extension == "JSON"){
-            format = ExportFormat::JSON; 
-        } else if (extension == "csv" || extension == "CSV"){
-            format = ExportFormat::CSV; 
-        } else {
-            format = ExportFormat::CSV; 
+        // the buffer may not be aligned, records are copied out with memcpy
+        BinaryHeader header;
+        memcpy(&header, content.data(), sizeof(BinaryHeader));
+        if (header.version != BINARY_VERSION) {
+            log(LogLevel::ERROR, LogCode::BINARY_VERSION, "");
+            return false;
+        }
+        if (header.byteOrder != BINARY_BYTE_ORDER) {
+            log(LogLevel::ERROR, LogCode::BINARY_BYTE_ORDER, "");
+            return false;
+        }
+        const uint64_t slotsSize = static_cast<uint64_t>(header.slotCount) * sizeof(BinarySlot);
+        if (sizeof(BinaryHeader) + slotsSize + header.stringsSize != content.size()) {
+            log(LogLevel::ERROR, LogCode::BINARY_CORRUPTED, "");
+            return false;
+        }
+        if (header.schemaHash != schemaHash()) {
+            log(LogLevel::WARNING, LogCode::BINARY_SCHEMA_MISMATCH, "");
         }
-#else
-        format = ExportFormat::CSV; 
-#endif
 
-        // serialize JSON
-#ifdef MINICONF_JSON_SUPPORT
-        if (format == ExportFormat::JSON) {
-            picojson::value outObj = picojson::value(picojson::object());
-            for (auto v: _optionValues){
-                std::vector<std::string> flagTokens;
-                std::stringstream ss(v.first);
-                // tokenize
-                while (ss.good()){
-                    std::string tempToken;
-                    std::getline(ss, tempToken, '.');
-                    flagTokens.emplace_back(tempToken);
+        const char* slots = content.data() + sizeof(BinaryHeader);
+        const char* strings = slots + slotsSize;
+        bool success = true;
+        for (uint32_t i = 0; i < header.slotCount; ++i) {
+            BinarySlot record;
+            memcpy(&record, slots + i * sizeof(BinarySlot), sizeof(BinarySlot));
+            if (static_cast<uint64_t>(record.key) + record.keyLength > header.stringsSize) {
+                log(LogLevel::ERROR, LogCode::BINARY_INVALID_FLAG, "");
+                return false;
+            }
+            StringRef flag(strings + record.key, record.keyLength);
+
+            if (!checkBinaryArray(strings, header, record)) {
+                log(LogLevel::ERROR, LogCode::BINARY_INVALID_ARRAY, flag);
+                return false;
+            }
+
+            Value value;
+            switch (static_cast<Value::DataType>(record.type)) {
+                case Value::DataType::INT:
+                    value = static_cast<int>(static_cast<int64_t>(record.payload));
+                    break;
+                case Value::DataType::NUMBER: {
+                    double number;
+                    memcpy(&number, &record.payload, sizeof(double));
+                    value = number;
+                    break;
                 }
-                // parse
-                if (flagTokens.size() > 1){
-                    picojson::value* thisObj = &outObj;
-                    for (size_t i = 0; i < flagTokens.size(); ++i){
-                        if (i != flagTokens.size() - 1){
-                            if (thisObj->get<picojson::object>().find(flagTokens[i]) == thisObj->get<picojson::object>().end()){
-                                thisObj->get<picojson::object>()[flagTokens[i]] = picojson::value(picojson::object());
-                            }
-                            thisObj = &(thisObj->get<picojson::object>()[flagTokens[i]]);
-                        } else {
-                            if (v.second.type() == Value::DataType::INT){
-                                thisObj->get<picojson::object>()[flagTokens[i]] = picojson::value(static_cast<double>(v.second.getInt()));
-                            } else if (v.second.type() == Value::DataType::NUMBER){
-                                thisObj->get<picojson::object>()[flagTokens[i]] = picojson::value(v.second.getNumber());
-                            } else if (v.second.type() == Value::DataType::BOOL){
-                                thisObj->get<picojson::object>()[flagTokens[i]] = picojson::value(v.second.getBoolean());
-                            } else if (v.second.type() == Value::DataType::STRING){
-                                thisObj->get<picojson::object>()[flagTokens[i]] = picojson::value(v.second.getString());
-                            } 
-                        
-                        }
+                case Value::DataType::BOOL:
+                    value = (record.payload != 0);
+                    break;
+                case Value::DataType::STRING:
+                    if (record.payload > header.stringsSize || record.length > header.stringsSize - record.payload) {
+                        log(LogLevel::ERROR, LogCode::BINARY_INVALID_STRING, flag);
+                        return false;
                     }
-                }else{
-                    if (outObj.get<picojson::object>().find(flagTokens[0]) == outObj.get<picojson::object>().end()){
-                        if (v.second.type() == Value::DataType::INT){
-                            outObj.get<picojson::object>()[flagTokens[0]] = picojson::value(static_cast<double>(v.second.getInt()));
-                        } else if (v.second.type() == Value::DataType::NUMBER){
-                            outObj.get<picojson::object>()[flagTokens[0]] = picojson::value(v.second.getNumber());
-                        } else if (v.second.type() == Value::DataType::BOOL){
-                            outObj.get<picojson::object>()[flagTokens[0]] = picojson::value(v.second.getBoolean());
-                        }  else if (v.second.type() == Value::DataType::STRING){
-                            outObj.get<picojson::object>()[flagTokens[0]] = picojson::value(v.second.getString());
-                        } 
+                    value = StringRef(strings + record.payload, record.length);
+                    break;
+                case Value::DataType::CHOICE: {
+                    if (record.payload > header.stringsSize || record.length > header.stringsSize - record.payload) {
+                        log(LogLevel::ERROR, LogCode::BINARY_INVALID_STRING, flag);
+                        return false;
                     }
+                    // the index is looked up by the name, an undefined choice is loaded as it is
+                    StringRef name(strings + record.payload, record.length);
+                    Option* choiceOpt = findFlag(flag.data(), flag.size());
+                    value = choiceOpt ? choiceOpt->choice(name) : Value::choice(-1, name);
+                    break;
                 }
-            }
-            outStr = outObj.serialize(true);
-        }
-#endif
-
-        // serialize CSV
-        if (format == ExportFormat::CSV) {
-            for (auto opt = std::begin(_optionValues); opt != std::end(_optionValues); ++opt) {
-                std::string flag = opt->first;
-                std::string val = opt->second.print();
-                if (opt->second.type() == Value::DataType::STRING){
-                    // remove "" from string
-                    if (val.size() >= 2){ 
-                        val = val.substr(1, val.size()-2);
+                case Value::DataType::INT_ARRAY:
+                    value = Value(ArrayRef<int>(reinterpret_cast<const int*>(strings + record.payload), record.length));
+                    break;
+                case Value::DataType::NUMBER_ARRAY:
+                    value = Value(ArrayRef<double>(reinterpret_cast<const double*>(strings + record.payload), record.length));
+                    break;
+                case Value::DataType::BOOL_ARRAY: {
+                    // any non-zero byte is true
+                    std::vector<bool> elements(record.length);
+                    for (uint32_t j = 0; j < record.length; ++j) {
+                        elements[j] = (strings[record.payload + j] != 0);
                     }
+                    value = Value(elements);
+                    break;
                 }
-                ss << flag << "," << val << std::endl; 
+                case Value::DataType::STRING_ARRAY: {
+                    std::vector<StringRef> elements(record.length);
+                    const uint32_t* pairs = reinterpret_cast<const uint32_t*>(strings + record.payload);
+                    for (uint32_t j = 0; j < record.length; ++j) {
+                        if (static_cast<uint64_t>(pairs[2 * j]) + pairs[2 * j + 1] > header.stringsSize) {
+                            log(LogLevel::ERROR, LogCode::BINARY_INVALID_STRING, flag);
+                            return false;
+                        }
+                        elements[j] = StringRef(strings + pairs[2 * j], pairs[2 * j + 1]);
+                    }
+                    value = Value(elements);
+                    break;
+                }
+                default:
+                    break;
+            }
+            if (value.isEmpty()) {
+                log(LogLevel::WARNING, LogCode::BINARY_UNSUPPORTED_TYPE, flag);
+                success = false;
+                continue;
             }
-            outStr = ss.str();
-        }
 
-        // write out file
-        if (!serializeFilePath.empty()) {
-            std::ofstream ofd(serializeFilePath);
-            if (ofd.good()) {
-                ofd << outStr;
-                ofd.close();
+            // the values are typed already, they are not converted to the option type
+            // except the name of a choice, which is written as a string if it was not mapped
+            Option* opt = findFlag(flag.data(), flag.size());
+            if (opt && opt->type() == Value::DataType::CHOICE && value.type() == Value::DataType::STRING) {
+                value = opt->choice(value.getStringRef());
+            }
+            if (opt && opt->type() != value.type()) {
+                log(LogLevel::WARNING, LogCode::BINARY_TYPE_MISMATCH, flag);
+                success = false;
+                continue;
             }
+            valueOf(flag) = std::move(value);
+            log(LogLevel::INFO, opt ? LogCode::VALUE_LOADED : LogCode::STRAY_VALUE_LOADED, flag);
         }
-        return outStr;
+        return success;
     }
 
-    void Config::config(const std::string& configPath)
+    bool Config::checkBinaryArray(const char* strings, const BinaryHeader& header, const BinarySlot& record)
     {
-        // read content of the file
-        std::ifstream ifd(configPath, std::ios::in | std::ios::binary);
-        std::string configContent = "";
-        if (ifd) {
-            configContent = std::string((std::istreambuf_iterator<char>(ifd)), std::istreambuf_iterator<char>());
+        size_t elementSize = 0;
+        switch (static_cast<Value::DataType>(record.type)) {
+            case Value::DataType::INT_ARRAY: elementSize = sizeof(int); break;
+            case Value::DataType::NUMBER_ARRAY: elementSize = sizeof(double); break;
+            case Value::DataType::BOOL_ARRAY: elementSize = sizeof(bool); break;
+            case Value::DataType::STRING_ARRAY: elementSize = 2 * sizeof(uint32_t); break;
+            default: return true;
         }
+        const uint64_t size = static_cast<uint64_t>(record.length) * elementSize;
+        return record.payload <= header.stringsSize 
+            && size <= header.stringsSize - record.payload 
+            && reinterpret_cast<uintptr_t>(strings + record.payload) % 8 == 0;
+    }
 
-        // extract extension
-        std::string extension = "";
-        size_t lastDot = configPath.find_last_of(".");
-        if (lastDot != std::string::npos) {
-            extension = configPath.substr(lastDot + 1);
+    void Config::writeBinary(Writer& out)
+    {
+        const std::vector<size_t>& valueSlots = _table.values();
+        std::vector<BinarySlot> records;
+        records.reserve(valueSlots.size());
+
+        // string table, identical strings are stored only once
+        std::string strings;
+        std::vector<StringRef> interned;
+        std::vector<uint32_t> offsets;
+        FlagIndex internIndex;
+        internIndex.reset(valueSlots.size() * 2);
+        auto intern = [&](const StringRef& str) -> uint32_t {
+            size_t found = internIndex.insert(str, interned.size(), [&](size_t id) { return interned[id]; });
+            if (found != NO_SLOT) {
+                return offsets[found];
+            }
+            uint32_t offset = static_cast<uint32_t>(strings.size());
+            interned.push_back(str);
+            offsets.push_back(offset);
+            strings.append(str.data(), str.size());
+            strings.push_back('\0');
+            return offset;
+        };
+
+        // array elements are aligned, so they can be referred to in the mapped file
+        auto appendArray = [&](const void* data, size_t size) -> uint64_t {
+            strings.append((8 - strings.size() % 8) % 8, '\0');
+            uint64_t offset = strings.size();
+            strings.append(static_cast<const char*>(data), size);
+            return offset;
+        };
+        std::vector<uint32_t> stringOffsets;
+
+        for (auto && slot : valueSlots) {
+            const Value& value = _table.value(slot);
+            if (value.isEmpty()) continue;
+            BinarySlot record;
+            StringRef key = _table.key(slot);
+            record.key = intern(key);
+            record.keyLength = static_cast<uint32_t>(key.size());
+            record.type = static_cast<uint32_t>(value.type());
+            record.length = 0;
+            record.payload = 0;
+            switch (value.type()) {
+                case Value::DataType::INT:
+                    record.payload = static_cast<uint64_t>(static_cast<int64_t>(value.getInt()));
+                    break;
+                case Value::DataType::NUMBER: {
+                    double number = value.getNumber();
+                    memcpy(&record.payload, &number, sizeof(double));
+                    break;
+                }
+                case Value::DataType::BOOL:
+                    record.payload = value.getBoolean() ? 1 : 0;
+                    break;
+                case Value::DataType::STRING:
+                case Value::DataType::CHOICE: {
+                    // a choice is stored by its name, the indices depend on the option
+                    StringRef str = value.getStringRef();
+                    record.payload = intern(str);
+                    record.length = static_cast<uint32_t>(str.size());
+                    break;
+                }
+                case Value::DataType::INT_ARRAY: {
+                    ArrayRef<int> elements = value.getIntArray();
+                    record.payload = appendArray(elements.data(), elements.size() * sizeof(int));
+                    record.length = static_cast<uint32_t>(elements.size());
+                    break;
+                }
+                case Value::DataType::NUMBER_ARRAY: {
+                    ArrayRef<double> elements = value.getNumberArray();
+                    record.payload = appendArray(elements.data(), elements.size() * sizeof(double));
+                    record.length = static_cast<uint32_t>(elements.size());
+                    break;
+                }
+                case Value::DataType::BOOL_ARRAY: {
+                    ArrayRef<bool> elements = value.getBooleanArray();
+                    record.payload = appendArray(elements.data(), elements.size() * sizeof(bool));
+                    record.length = static_cast<uint32_t>(elements.size());
+                    break;
+                }
+                case Value::DataType::STRING_ARRAY: {
+                    ArrayRef<StringRef> elements = value.getStringArray();
+                    stringOffsets.clear();
+                    for (size_t i = 0; i < elements.size(); ++i) {
+                        stringOffsets.push_back(intern(elements[i]));
+                        stringOffsets.push_back(static_cast<uint32_t>(elements[i].size()));
+                    }
+                    record.payload = appendArray(stringOffsets.data(), stringOffsets.size() * sizeof(uint32_t));
+                    record.length = static_cast<uint32_t>(elements.size());
+                    break;
+                }
+                default:
+                    break;
+            }
+            records.push_back(record);
         }
 
-        // load config according to extension
-        // default is json
-#ifdef MINICONF_JSON_SUPPORT
-        if (extension == "json" || extension == "JSON") {
-            loadJSON(configContent);
-            return;
-        } else if (extension == "csv" || extension == "CSV") {
-            loadCSV(configContent);
-            return;
-        } else {
-            loadJSON(configContent);
+        BinaryHeader header;
+        memcpy(header.magic, "MINICONF", 8);
+        header.version = BINARY_VERSION;
+        header.byteOrder = BINARY_BYTE_ORDER;
+        header.schemaHash = schemaHash();
+        header.slotCount = static_cast<uint32_t>(records.size());
+        header.stringsSize = static_cast<uint32_t>(strings.size());
+
+        out.write(reinterpret_cast<const char*>(&header), sizeof(BinaryHeader));
+        if (!records.empty()) {
+            out.write(reinterpret_cast<const char*>(records.data()), records.size() * sizeof(BinarySlot));
         }
-#else
-        loadCSV(configContent);
-#endif
+        out.write(strings);
+    }
 
-        return;
+    uint64_t Config::schemaHash()
+    {
+        // FNV-1a over the sorted flags and their data types
+        uint64_t h = 14695981039346656037ULL;
+        for (auto && slot : _table.options()) {
+            StringRef key = _table.key(slot);
+            for (size_t i = 0; i < key.size(); ++i) {
+                h = (h ^ static_cast<unsigned char>(key.data()[i])) * 1099511628211ULL;
+            }
+            h *= 1099511628211ULL; // a null separator
+            h = (h ^ static_cast<uint64_t>(_table.option(slot).type())) * 1099511628211ULL;
+        }
+        return h;
     }
 
-    bool Config::loadCSV(const std::string& CSVStr)
+    bool Config::loadCSV(const StringRef& CSVStr)
     {
-        std::stringstream ss(CSVStr);
         bool success = true;
-        while (ss.good()){
-            std::string templine;
-            std::getline(ss, templine);
-            std::stringstream lss(templine);
-            if (templine.empty()){
-                continue; 
-            }
-            while (lss.good()){
-                std::string sflag;
-                std::string svalue;
-                std::getline(lss, sflag, ',');
-                std::getline(lss, svalue, ',');
+        const char* pos = CSVStr.data();
+        const char* end = pos + CSVStr.size();
+        // buffers of quoted fields and of the value to be parsed, reused for all rows
+        std::string flagBuffer;
+        std::string valueBuffer;
+        // buffers and references of array elements, a deque keeps the buffers in place
+        std::deque<std::string> elementBuffers;
+        std::vector<StringRef> elements;
+        while (pos < end){
+            // each record contains one or more "flag,value" pairs
+            // or a flag of an array option followed by all the elements
+            bool endOfRecord = false;
+            while (!endOfRecord){
+                StringRef sflag = readCSVField(pos, end, flagBuffer, endOfRecord);
+                Option* opt = findFlag(sflag.data(), sflag.size());
+                if (opt && opt->defaultValue().isArray()){
+                    // quoted elements are unescaped into their own buffers
+                    elements.clear();
+                    while (!endOfRecord){
+                        if (elementBuffers.size() <= elements.size()){
+                            elementBuffers.resize(elements.size() + 1);
+                        }
+                        StringRef element = readCSVField(pos, end, elementBuffers[elements.size()], endOfRecord);
+                        elements.push_back(element);
+                    }
+                    // "flag," is an empty array
+                    if (elements.size() == 1 && elements[0].empty()){
+                        elements.clear();
+                    }
+                    Value newValue = parseArray(elements, opt->type());
+                    if (newValue.isEmpty()){
+                        log(LogLevel::WARNING, LogCode::CONFIG_VALUE_INVALID, sflag);
+                        success = false;
+                    } else {
+                        valueOf(sflag) = std::move(newValue);
+                        log(LogLevel::INFO, LogCode::VALUE_LOADED, sflag);
+                    }
+                    continue;
+                }
+                StringRef svalue;
+                if (!endOfRecord){
+                    svalue = readCSVField(pos, end, valueBuffer, endOfRecord);
+                }
                 if (svalue.empty()){
                     continue; 
-                    success = false;
                 }
-                // check if options exists
-                if (findOption(sflag)){
-                    // parse the default data type
-                    _optionValues[sflag] = parseValue(svalue.c_str(), _options[sflag].type()); 
-                    log(LogLevel::INFO, std::string(sflag), "value is loaded from config");
+                if (opt){
+                    // parse the default data type, a choice is mapped to its index
+                    Value newValue = (opt->type() == Value::DataType::CHOICE) ? opt->choice(svalue) : parseValue(svalue, opt->type());
+                    // a value which does not parse keeps the existing one
+                    if (newValue.isEmpty()){
+                        log(LogLevel::WARNING, LogCode::CONFIG_VALUE_INVALID, sflag);
+                        success = false;
+                    } else {
+                        valueOf(sflag) = std::move(newValue);
+                        log(LogLevel::INFO, LogCode::VALUE_LOADED, sflag);
+                    }
                 } else {
                     // parse string when the flag does not exist in the original configuration
-                    _optionValues[sflag] = parseValue(svalue.c_str(), Value::DataType::STRING);
-                    log(LogLevel::INFO, std::string(sflag), "value is not defined in config, parsed as a string value");
+                    valueOf(sflag) = parseValue(svalue, Value::DataType::STRING);
+                    log(LogLevel::INFO, LogCode::STRAY_VALUE_AS_STRING, sflag);
                 }
             }
         }
@@ -1547,75 +7685,349 @@ namespace miniconf
     }
  
 #ifdef MINICONF_JSON_SUPPORT
-    bool Config::getJSONValue(const picojson::value *v, const std::string& flag){
+    bool Config::getJSONValue(Value&& v, const std::string& flag){
         bool success = true;
-        if (findOption(flag)){
-            Config::Option opt = _options[flag];
-            if (opt.type() == Value::DataType::INT && v->is<double>()){
-                _optionValues[flag] = static_cast<int>(v->get<double>());
-            } else if (opt.type() == Value::DataType::NUMBER && v->is<double>()) {
-                _optionValues[flag] = v->get<double>();
-            } else if (opt.type() == Value::DataType::BOOL && v->is<bool>()) {
-                _optionValues[flag] = v->get<bool>();
-            } else if (opt.type() == Value::DataType::STRING && v->is<std::string>()) {
-                _optionValues[flag] = v->get<std::string>();
+        Config::Option* opt = findFlag(flag.c_str(), flag.size());
+        if (opt){
+            int number = 0;
+            if (opt->type() == Value::DataType::INT && v.type() == Value::DataType::NUMBER){
+                // a number with a fraction or out of the int range is rejected, not truncated
+                if (NumberParser::toInt(v.getNumber(), number)) {
+                    (*this)[flag] = number;
+                } else {
+                    log(LogLevel::WARNING, LogCode::CONFIG_VALUE_TYPE_MISMATCH, flag, flag);
+                    success = false;
+                }
+            } else if (opt->type() == Value::DataType::INT_ARRAY && v.type() == Value::DataType::NUMBER_ARRAY){
+                // the whole array is rejected if an element is not an int
+                ArrayRef<double> numbers = v.getNumberArray();
+                std::vector<int> elements(numbers.size());
+                bool valid = true;
+                for (size_t i = 0; i < numbers.size() && valid; ++i){
+                    valid = NumberParser::toInt(numbers[i], elements[i]);
+                }
+                if (valid) {
+                    (*this)[flag] = Value(elements);
+                } else {
+                    log(LogLevel::WARNING, LogCode::CONFIG_ARRAY_INVALID, flag);
+                    success = false;
+                }
+            } else if (opt->type() == Value::DataType::INT_ARRAY && v.type() == Value::DataType::INT_ARRAY){
+                (*this)[flag] = std::move(v);
+            } else if (opt->type() == Value::DataType::CHOICE && v.type() == Value::DataType::STRING){
+                (*this)[flag] = opt->choice(v.getStringRef());
+            } else if (opt->type() == v.type() && opt->type() != Value::DataType::INT) {
+                (*this)[flag] = std::move(v);
             } else {
-                log(LogLevel::WARNING, flag, "Unable to parse the option from config file, flag = " + flag);
+                log(LogLevel::WARNING, LogCode::CONFIG_VALUE_TYPE_MISMATCH, flag, flag);
                 success = false;
             }
         }
         // stray options
         else 
         {
-            if (v->is<double>()){
-                _optionValues[flag] = v->get<double>();
-            } 
-            else if (v->is<bool>()) {
-                _optionValues[flag] = v->get<bool>();
-            } else if (v->is<std::string>()) {
-                _optionValues[flag] = v->get<std::string>();
-            } else {
-                log(LogLevel::WARNING, flag, "Unable to parse the option from config file.");
-                success = false;
-            }
+            (*this)[flag] = std::move(v);
         }
         return success;
     }
 
-    bool Config::parseJSON(const picojson::value *v, const std::string& flag){
-        if (v->is<double>() || v->is<bool>() || v->is<std::string>()){
-            return getJSONValue(v, flag);
-        } else if (v->is<picojson::object>()){
-            bool success = true;
-            for (auto objItem: v->get<picojson::object>()){
-                success = success && parseJSON(&(objItem.second), flag + (flag.empty() ? "" : ".") + objItem.first);
-            }
-            return success;
-        } else if (v->is<picojson::array>()){
-            for (auto arrayItem : v->get<picojson::array>()){
-                // print array, not supported yet
-            }
+    // JSONContext
+    Config::JSONContext::JSONContext(Config& config) : 
+        _config(config), 
+        _flag(), 
+        _string(), 
+        _success(true),
+        _inArray(false),
+        _arrayValid(true),
+        _elementType(Value::DataType::UNKNOWN),
+        _numbers(),
+        _booleans(),
+        _strings(),
+        _depth(0),
+        _tooDeep(false)
+    {}
+
+    bool Config::JSONContext::success() const
+    {
+        return _success;
+    }
+
+    bool Config::JSONContext::tooDeep() const
+    {
+        return _tooDeep;
+    }
+
+    bool Config::JSONContext::enter()
+    {
+        // picojson recurses for each level, the limit bounds the stack of a hostile file
+        if (_config._jsonMaxDepth > 0 && _depth >= _config._jsonMaxDepth) {
+            _tooDeep = true;
+            return false;
+        }
+        ++_depth;
+        return true;
+    }
+
+    void Config::JSONContext::leave()
+    {
+        --_depth;
+    }
+
+    bool Config::JSONContext::set_null()
+    {
+        if (_inArray) {
+            _arrayValid = false;
+            return true;
+        }
+        _config.log(LogLevel::WARNING, LogCode::CONFIG_VALUE_INVALID, _flag);
+        _success = false;
+        return true;
+    }
+
+    bool Config::JSONContext::set_bool(bool b)
+    {
+        if (_inArray) {
+            if (addElement(Value::DataType::BOOL)) _booleans.push_back(b);
+            return true;
+        }
+        _success = _config.getJSONValue(Value(b), _flag) && _success;
+        return true;
+    }
+
+    bool Config::JSONContext::set_number(double f)
+    {
+        if (_inArray) {
+            if (addElement(Value::DataType::NUMBER)) _numbers.push_back(f);
+            return true;
+        }
+        _success = _config.getJSONValue(Value(f), _flag) && _success;
+        return true;
+    }
+
+#ifdef PICOJSON_USE_INT64
+    bool Config::JSONContext::set_int64(int64_t i)
+    {
+        return set_number(static_cast<double>(i));
+    }
+#endif
+
+    template <typename Iter>
+    bool Config::JSONContext::parse_string(picojson::input<Iter>& in)
+    {
+        _string.clear();
+        if (!picojson::_parse_string(_string, in)) {
+            return false;
+        }
+        if (_inArray) {
+            if (addElement(Value::DataType::STRING)) _strings.push_back(_string);
+            return true;
+        }
+        _success = _config.getJSONValue(Value(_string), _flag) && _success;
+        return true;
+    }
+
+    bool Config::JSONContext::parse_array_start()
+    {
+        // an array is a value of the current flag, the root cannot be an array
+        _inArray = true;
+        _arrayValid = !_flag.empty();
+        _elementType = Value::DataType::UNKNOWN;
+        _numbers.clear();
+        _booleans.clear();
+        _strings.clear();
+        return true;
+    }
+
+    template <typename Iter>
+    bool Config::JSONContext::parse_array_item(picojson::input<Iter>& in, size_t)
+    {
+        // nested arrays and objects are not supported, they are skipped
+        in.skip_ws();
+        int ch = in.getc();
+        in.ungetc();
+        if (!enter()) {
+            return false;
+        }
+        bool parsed;
+        if (ch == '[' || ch == '{') {
+            _arrayValid = false;
+            SkipContext skip(*this);
+            parsed = picojson::_parse(skip, in);
         } else {
-            log(LogLevel::WARNING, flag, "Unable to parse JSON, abort, flag = " + flag);
+            parsed = parseValue(in);
+        }
+        leave();
+        return parsed;
+    }
+
+    bool Config::JSONContext::parse_array_stop(size_t)
+    {
+        _inArray = false;
+        if (!_arrayValid) {
+            _config.log(LogLevel::WARNING, LogCode::CONFIG_ARRAY_INVALID, _flag);
+            _success = false;
+            return true;
+        }
+        if (_elementType == Value::DataType::UNKNOWN) {
+            // an empty array takes the type of the option
+            Config::Option* opt = _config.findFlag(_flag.c_str(), _flag.size());
+            _elementType = (opt && opt->defaultValue().isArray()) ? Value::elementType(opt->type()) : Value::DataType::STRING;
+        }
+        Value v;
+        switch (_elementType) {
+            case Value::DataType::INT:
+                v = Value(std::vector<int>());
+                break;
+            case Value::DataType::NUMBER:
+                v = Value(_numbers);
+                break;
+            case Value::DataType::BOOL:
+                v = Value(_booleans);
+                break;
+            default:
+                v = Value(_strings);
+                break;
+        }
+        _success = _config.getJSONValue(std::move(v), _flag) && _success;
+        return true;
+    }
+
+    bool Config::JSONContext::addElement(Value::DataType type)
+    {
+        if (_elementType != Value::DataType::UNKNOWN && _elementType != type) {
+            _arrayValid = false;
+        }
+        _elementType = type;
+        return _arrayValid;
+    }
+
+    bool Config::JSONContext::parse_object_start()
+    {
+        return true;
+    }
+
+    template <typename Iter>
+    bool Config::JSONContext::parse_object_item(picojson::input<Iter>& in, const std::string& key)
+    {
+        // extend the dotted flag for the nested value, and restore it afterwards
+        size_t parentLength = _flag.size();
+        if (parentLength > 0) {
+            _flag.push_back('.');
+        }
+        _flag.append(key);
+        if (!enter()) {
             return false;
         }
-        return false;
+        bool parsed = parseValue(in);
+        leave();
+        _flag.resize(parentLength);
+        return parsed;
+    }
+
+    // SkipContext
+    Config::JSONContext::SkipContext::SkipContext(JSONContext& parent) : picojson::null_parse_context(), _parent(parent)
+    {}
+
+    template <typename Iter>
+    bool Config::JSONContext::SkipContext::parse_array_item(picojson::input<Iter>& in, size_t)
+    {
+        if (!_parent.enter()) {
+            return false;
+        }
+        bool parsed = picojson::_parse(*this, in);
+        _parent.leave();
+        return parsed;
+    }
+
+    template <typename Iter>
+    bool Config::JSONContext::SkipContext::parse_object_item(picojson::input<Iter>& in, const std::string&)
+    {
+        if (!_parent.enter()) {
+            return false;
+        }
+        bool parsed = picojson::_parse(*this, in);
+        _parent.leave();
+        return parsed;
+    }
+
+    template <typename Iter>
+    bool Config::JSONContext::parseValue(picojson::input<Iter>& in)
+    {
+        in.skip_ws();
+        int ch = in.getc();
+        in.ungetc();
+        if (!(('0' <= ch && ch <= '9') || ch == '-')) {
+            return picojson::_parse(*this, in);
+        }
+        // collect the number literal, picojson would convert it with the global locale
+        _string.clear();
+        while (true) {
+            ch = in.getc();
+            if (('0' <= ch && ch <= '9') || ch == '+' || ch == '-' || ch == '.' || ch == 'e' || ch == 'E') {
+                _string.push_back(static_cast<char>(ch));
+            } else {
+                in.ungetc();
+                break;
+            }
+        }
+        double v;
+        if (!NumberParser::parseNumber(_string, v)) {
+            return false;
+        }
+        return set_number(v);
+    }
+
+    void Config::jsonLimits(size_t maxDepth, size_t maxSize)
+    {
+        _jsonMaxDepth = maxDepth;
+        _jsonMaxSize = maxSize;
     }
 
-    bool Config::loadJSON(const std::string& JSONStr)
+    bool Config::loadJSON(const StringRef& JSONStr)
     {
-        picojson::value json;
-        picojson::parse(json, JSONStr);
-        return parseJSON(&json, "");
+        if (_jsonMaxSize > 0 && JSONStr.size() > _jsonMaxSize) {
+            log(LogLevel::WARNING, LogCode::JSON_TOO_LARGE, "", std::to_string(_jsonMaxSize));
+            return false;
+        }
+        // the values are staged, so a document which fails to parse stores none of them
+        Staging* outer = staging();
+        Staging local;
+        Staging& stage = outer ? *outer : local;
+        // a value takes several bytes of json, the buffer rarely grows while parsing
+        stage.values.reserve(stage.values.size() + std::min(_table.size(), JSONStr.size() / 4));
+        const size_t values = stage.values.size();
+        const size_t strays = stage.strays.size();
+        staging() = &stage;
+        JSONContext ctx(*this);
+        std::string err;
+        const char* first = JSONStr.data();
+        const char* last = first + JSONStr.size();
+        picojson::_parse(ctx, first, last, &err);
+        bool parsed = false;
+        if (ctx.tooDeep()) {
+            log(LogLevel::WARNING, LogCode::JSON_TOO_DEEP, "", std::to_string(_jsonMaxDepth));
+        } else if (!err.empty()) {
+            log(LogLevel::WARNING, LogCode::JSON_INVALID, "", err);
+        } else {
+            parsed = true;
+        }
+        staging() = outer;
+        // an invalid value does not discard the others, as with the document parser
+        if (!parsed) {
+            stage.values.erase(stage.values.begin() + values, stage.values.end());
+            stage.strays.erase(stage.strays.begin() + strays, stage.strays.end());
+        }
+        if (!outer) {
+            commitStage(local);
+        }
+        return parsed && ctx.success();
     }
 #endif
 
 }
 
 // TODO: Stray arguments
-// TODO: Support choice (value must be chosen form a list)
 // TODO: Beautiful print, in help() and usage(), instead of printf()
-// TODO: Support array
 // TODO: Switch to JSON backend?
 
 #endif // __MINICONF_H__
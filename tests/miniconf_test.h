@@ -0,0 +1,50 @@
+/*
+ * miniconf tests
+ *
+ * Each test is a program which returns a non-zero status if a check fails, they are
+ * registered with CTest and run by "ctest" (or "make test") in the build directory.
+ */
+
+#ifndef __MINICONF_TEST_H__
+#define __MINICONF_TEST_H__
+
+#include <cstdio>
+#include <string>
+
+// reports a failed check, the test goes on so all the failures are listed
+#define MINICONF_CHECK(condition) miniconf_test::check((condition), #condition, __FILE__, __LINE__)
+
+namespace miniconf_test {
+
+    // number of failed checks
+    static int failures = 0;
+
+    inline void check(bool passed, const char* condition, const char* file, int line)
+    {
+        if (!passed) {
+            fprintf(stderr, "%s:%d: check failed: %s\n", file, line, condition);
+            ++failures;
+        }
+    }
+
+    // writes a file, e.g. a config file loaded by the test
+    inline void writeFile(const std::string& path, const std::string& content)
+    {
+        FILE* file = fopen(path.c_str(), "wb");
+        if (file) {
+            fwrite(content.data(), 1, content.size(), file);
+            fclose(file);
+        }
+    }
+
+    // gets the exit status of the test
+    inline int result()
+    {
+        if (failures > 0) {
+            fprintf(stderr, "%d check(s) failed\n", failures);
+        }
+        return failures > 0 ? 1 : 0;
+    }
+}
+
+#endif // __MINICONF_TEST_H__
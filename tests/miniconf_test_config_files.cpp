@@ -0,0 +1,101 @@
+/*
+ * Config::configFiles() test
+ *
+ * Files of every format, an invalid file and a missing file are loaded on 1 to 16
+ * threads. The values and the log must be the same as loading the files one by one
+ * with Config::config().
+ */
+
+// the files are loaded on a pool of threads
+#define MINICONF_THREAD_SUPPORT
+
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <miniconf.h>
+#include "miniconf_test.h"
+
+namespace {
+
+    const size_t FILES = 12;
+
+    void defineOptions(miniconf::Config& conf)
+    {
+        conf.option("count").shortflag("c").defaultValue(0).description("an integer");
+        conf.option("ratio").shortflag("r").defaultValue(0.5).description("a number");
+        conf.option("name").shortflag("n").defaultValue("none").description("a string");
+        conf.option("part.sizes").defaultValue(std::vector<int>{1, 2}).description("integers");
+        conf.option("part.mode").shortflag("m").choices({"fast", "slow"}).defaultValue("fast").description("a choice");
+    }
+
+    // collects the log messages of a Config
+    std::vector<std::string> collectLog(miniconf::Config& conf)
+    {
+        std::vector<std::string> messages;
+        conf.readLog([&messages](const miniconf::Config::LogRecord& record) {
+            messages.push_back(std::to_string(static_cast<int>(record.level)) + ":" + 
+                std::to_string(static_cast<int>(record.code)) + ":" + record.token.str() + ":" + record.detail.str());
+        });
+        return messages;
+    }
+
+    // writes config files overriding some of the values of the previous ones, each format in turn
+    std::vector<std::string> writeFiles()
+    {
+        std::vector<std::string> paths;
+        for (size_t i = 0; i < FILES; ++i) {
+            miniconf::Config conf;
+            defineOptions(conf);
+            conf["count"] = static_cast<int>(i);
+            if (i % 2) {
+                conf["ratio"] = 0.25 * i;
+            }
+            if (i % 3 == 0) {
+                conf["name"] = "file" + std::to_string(i);
+            }
+            conf["part.sizes"] = miniconf::Value(std::vector<int>(i % 5, static_cast<int>(i)));
+            conf["stray" + std::to_string(i)] = static_cast<int>(i);
+            std::string path = "miniconf_test_config_files_" + std::to_string(i);
+            switch (i % 3) {
+                case 0: path += ".json"; conf.serialize(path, miniconf::Config::ExportFormat::JSON); break;
+                case 1: path += ".csv"; conf.serialize(path, miniconf::Config::ExportFormat::CSV); break;
+                default: path += ".bin"; conf.serialize(path, miniconf::Config::ExportFormat::BINARY); break;
+            }
+            paths.push_back(path);
+        }
+        // a truncated file stores none of its values, a missing file is logged
+        paths.insert(paths.begin() + 5, "miniconf_test_config_files_invalid.json");
+        miniconf_test::writeFile(paths[5], "{\"count\": 99, \"name\": ");
+        paths.insert(paths.begin() + 8, "miniconf_test_config_files_missing.json");
+        return paths;
+    }
+}
+
+int main()
+{
+    std::vector<std::string> paths = writeFiles();
+
+    miniconf::Config sequential;
+    defineOptions(sequential);
+    for (auto && path : paths) {
+        sequential.config(path);
+    }
+    const std::string values = sequential.serialize("", miniconf::Config::ExportFormat::JSON);
+    const std::vector<std::string> log = collectLog(sequential);
+    MINICONF_CHECK(sequential["count"].getInt() == static_cast<int>(FILES - 1));
+    MINICONF_CHECK(sequential["name"].getString() == "file9");
+    MINICONF_CHECK(sequential.contains("stray0") && sequential.contains("stray11"));
+
+    for (size_t threads = 1; threads <= 16; ++threads) {
+        miniconf::Config conf;
+        defineOptions(conf);
+        MINICONF_CHECK(conf.configFiles(paths, threads) == FILES);
+        MINICONF_CHECK(conf.serialize("", miniconf::Config::ExportFormat::JSON) == values);
+        MINICONF_CHECK(collectLog(conf) == log);
+    }
+
+    for (auto && path : paths) {
+        remove(path.c_str());
+    }
+    return miniconf_test::result();
+}
@@ -0,0 +1,85 @@
+/*
+ * Config::environment() test
+ *
+ * The variable names of nested flags, the values of each data type, and flags which
+ * map to the same variable name.
+ */
+
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include <miniconf.h>
+#include "miniconf_test.h"
+
+namespace {
+
+    // counts the log messages of a code, and gets the token and the detail of the last one
+    size_t countLog(miniconf::Config& conf, miniconf::Config::LogCode code, std::string* token = nullptr, std::string* detail = nullptr)
+    {
+        size_t count = 0;
+        conf.readLog([&](const miniconf::Config::LogRecord& record) {
+            if (record.code == code) {
+                ++count;
+                if (token) {
+                    *token = record.token.str();
+                }
+                if (detail) {
+                    *detail = record.detail.str();
+                }
+            }
+        });
+        return count;
+    }
+}
+
+int main()
+{
+    setenv("MINICONF_TEST_PART2__SUBPART1__VALUE1", "hello", 1);
+    setenv("MINICONF_TEST_NUMOPT", "6.28", 1);
+    setenv("MINICONF_TEST_A_B", "7", 1);
+    setenv("MINICONF_TEST_X__Y", "1,2,3", 1);
+    setenv("MINICONF_TEST_MODE", "slow", 1);
+    setenv("MINICONF_TEST_UNKNOWN", "ignored", 1);
+
+    // the example of the README
+    {
+        miniconf::Config conf;
+        conf.option("part2.subpart1.value1").defaultValue("none");
+        conf.option("numOpt").defaultValue(1.0);
+        conf.option("x.y").defaultValue(std::vector<int>{0});
+        conf.option("mode").choices({"fast", "slow"}).defaultValue("fast");
+        MINICONF_CHECK(conf.environment("MINICONF_TEST_") == 4);
+        MINICONF_CHECK(conf["part2.subpart1.value1"].getString() == "hello");
+        MINICONF_CHECK(conf["numOpt"].getNumber() == 6.28);
+        MINICONF_CHECK(conf["x.y"].getIntArray().size() == 3 && conf["x.y"].getIntArray()[2] == 3);
+        MINICONF_CHECK(conf["mode"].getInt() == 1);
+        MINICONF_CHECK(!conf.contains("unknown"));
+        MINICONF_CHECK(countLog(conf, miniconf::Config::LogCode::ENVIRONMENT_NAME_COLLISION) == 0);
+    }
+
+    // flags which differ in case or punctuation, the flag sorting first is loaded
+    {
+        miniconf::Config conf;
+        conf.option("numOpt").defaultValue(1.0);
+        conf.option("numopt").defaultValue(2.0);
+        conf.option("a-b").defaultValue(0);
+        conf.option("a_b").defaultValue(0);
+        MINICONF_CHECK(conf.environment("MINICONF_TEST_") == 2);
+        MINICONF_CHECK(conf["numOpt"].getNumber() == 6.28);
+        MINICONF_CHECK(conf["a-b"].getInt() == 7);
+        MINICONF_CHECK(countLog(conf, miniconf::Config::LogCode::ENVIRONMENT_NAME_COLLISION) == 2);
+    }
+
+    // a nested flag and a flag with "__"
+    {
+        miniconf::Config conf;
+        conf.option("x.y").defaultValue(std::vector<int>{0});
+        conf.option("x__y").defaultValue(std::vector<int>{0});
+        std::string token;
+        std::string detail;
+        MINICONF_CHECK(conf.environment("MINICONF_TEST_") == 1);
+        MINICONF_CHECK(countLog(conf, miniconf::Config::LogCode::ENVIRONMENT_NAME_COLLISION, &token, &detail) == 1);
+        MINICONF_CHECK(token == "x__y" && detail == "x.y");
+    }
+    return miniconf_test::result();
+}